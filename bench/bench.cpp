@@ -0,0 +1,57 @@
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bench_kernels.h"
+#include "bench_report.h"
+#include "bench_solvers.h"
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    bool kernels = true;
+    bool solvers = true;
+    std::string set3 = "bench/instances/8puzzle_seeded.txt";
+    // 15-puzzle sets with whether they are in Korf's layout, the first --set4 or --korf4 replaces the shipped ones
+    std::vector<std::pair<std::string, bool>> sets4 = {{"bench/instances/15puzzle_walk.txt", false}, {"bench/instances/15puzzle_seeded.txt", false}};
+    bool default_sets4 = true;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--kernels") {
+            solvers = false;
+        } else if (arg == "--solvers") {
+            kernels = false;
+        } else if (arg == "--set3" && i + 1 < argc) {
+            set3 = argv[++i];
+        } else if ((arg == "--set4" || arg == "--korf4") && i + 1 < argc) {
+            if (std::exchange(default_sets4, false)) {
+                sets4.clear();
+            }
+            sets4.emplace_back(argv[++i], arg == "--korf4");
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--json] [--kernels | --solvers] [--set3 file] [--set4 file]... [--korf4 file]...\n";
+            return 1;
+        }
+    }
+    bench::report out(std::cout, json);
+    try {
+        if (kernels) {
+            bench::bench_kernels<3>(out);
+            bench::bench_kernels<4>(out);
+        }
+        if (solvers) {
+            bench::bench_solvers<3>(out, set3, bench::read_instances<3>(set3));
+            for (const auto& [set4, korf] : sets4) {
+                bench::bench_solvers<4>(out, set4, korf ? bench::read_instances_korf<4>(set4) : bench::read_instances<4>(set4));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
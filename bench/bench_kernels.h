@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_generator.h"
+#include "15puzzle_rank.h"
+#include "15puzzle_simd.h"
+#include "15puzzle_walking_distance.h"
+#include "bench_report.h"
+
+namespace bench {
+
+// random boards, half of them unsolvable which does not matter for the kernels
+template <uint32_t psize>
+std::vector<puzzle::permut_type> random_states(size_t n, uint32_t seed) {
+    std::mt19937 src_of_randomnes(seed);
+    std::array<uint32_t, psize * psize> arr;
+    std::iota(arr.begin(), arr.end(), 0);
+    std::vector<puzzle::permut_type> states(n);
+    for (auto& state : states) {
+        std::shuffle(arr.begin(), arr.end(), src_of_randomnes);
+        state = puzzle::permut_create<psize>(arr);
+    }
+    return states;
+}
+
+// runs kernel over the states until min_seconds pass, reports the states per second and the checksum of the last run
+template <typename Kernel>
+void time_kernel(report& out, std::string_view name, uint32_t psize, size_t n_states, Kernel kernel) {
+    constexpr double min_seconds = 0.5;
+    const auto start = std::chrono::steady_clock::now();
+    size_t rounds = 0;
+    uint64_t checksum = 0;
+    double seconds = 0;
+    do {
+        checksum = kernel();
+        ++rounds;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (seconds < min_seconds);
+    out.row("kernel", {{"name", std::string(name)}, {"psize", uint64_t{psize}}, {"mstates_per_s", rounds * n_states / seconds / 1e6}, {"checksum", checksum}});
+}
+
+template <uint32_t psize>
+void bench_kernels(report& out) {
+    constexpr size_t n_states = 1 << 14;
+    const auto states = random_states<psize>(n_states, 1);
+    std::vector<puzzle::dist_type> dists(n_states);
+    auto sum = [&dists] {
+        return std::accumulate(dists.begin(), dists.end(), uint64_t{0});
+    };
+    time_kernel(out, "manhattan_dist", psize, n_states, [&] {
+        uint64_t checksum = 0;
+        for (auto state : states) {
+            checksum += puzzle::manhattan_dist<psize>(state);
+        }
+        return checksum;
+    });
+    time_kernel(out, "manhattan_dist_batch_scalar", psize, n_states, [&] {
+        puzzle::manhattan_dist_batch_scalar<psize>(states.data(), n_states, dists.data());
+        return sum();
+    });
+#ifdef PUZZLE_X86_SIMD
+    if (__builtin_cpu_supports("ssse3")) {
+        time_kernel(out, "manhattan_dist_batch_ssse3", psize, n_states, [&] {
+            puzzle::manhattan_dist_batch_ssse3<psize>(states.data(), n_states, dists.data());
+            return sum();
+        });
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        time_kernel(out, "manhattan_dist_batch_avx2", psize, n_states, [&] {
+            puzzle::manhattan_dist_batch_avx2<psize>(states.data(), n_states, dists.data());
+            return sum();
+        });
+    }
+#endif
+    time_kernel(out, "manhattan_dist_neighbors", psize, n_states, [&] {
+        uint64_t checksum = 0;
+        std::array<puzzle::dist_type, 4> n_dists;
+        for (auto state : states) {
+            puzzle::permut_neighbors_itr_winfo<psize> neighbours(state);
+            const unsigned len = puzzle::manhattan_dist_neighbors<psize>(neighbours, n_dists.data());
+            checksum += std::accumulate(n_dists.begin(), n_dists.begin() + len, 0U);
+        }
+        return checksum;
+    });
+    time_kernel(out, "linear_conflict", psize, n_states, [&] {
+        uint64_t checksum = 0;
+        for (auto state : states) {
+            checksum += puzzle::linear_conflict<psize>(state);
+        }
+        return checksum;
+    });
+    std::vector<puzzle::permut_type> moved(n_states);
+    std::vector<puzzle::dist_type> lcs(n_states);
+    for (size_t i = 0; i < n_states; ++i) {
+        puzzle::permut_neighbors_itr<psize> neighbours(states[i]);
+        moved[i] = *neighbours.begin();
+        lcs[i] = puzzle::linear_conflict<psize>(states[i]);
+    }
+    time_kernel(out, "linear_conflict_update", psize, n_states, [&] {
+        uint64_t checksum = 0;
+        for (size_t i = 0; i < n_states; ++i) {
+            checksum += puzzle::linear_conflict_update<psize>(states[i], moved[i], lcs[i]);
+        }
+        return checksum;
+    });
+    const auto& wd_tables = puzzle::wd_tables<psize>();
+    time_kernel(out, "walking_distance", psize, n_states, [&] {
+        uint64_t checksum = 0;
+        for (auto state : states) {
+            checksum += puzzle::walking_distance<psize>(wd_tables, state);
+        }
+        return checksum;
+    });
+    std::mt19937_64 src_of_randomnes(1);
+    time_kernel(out, "permut_random", psize, n_states, [&] {
+        uint64_t checksum = 0;
+        for (size_t i = 0; i < n_states; ++i) {
+            checksum += static_cast<uint64_t>(puzzle::permut_random<psize>(src_of_randomnes));
+        }
+        return checksum;
+    });
+    std::vector<uint64_t> ranks(n_states);
+    time_kernel(out, "permut_rank_batch", psize, n_states, [&] {
+        puzzle::permut_rank_batch<psize>(states.data(), n_states, ranks.data());
+        return std::accumulate(ranks.begin(), ranks.end(), uint64_t{0});
+    });
+    time_kernel(out, "permut_unrank_batch", psize, n_states, [&] {
+        puzzle::permut_unrank_batch<psize>(ranks.data(), n_states, moved.data());
+        return std::accumulate(moved.begin(), moved.end(), uint64_t{0});
+    });
+    // the first tiles of the board as a pattern, like a pattern database lookup
+    const auto pattern = puzzle::tiles_in_order<psize * psize - 1>();
+    const std::vector<uint8_t> tiles(pattern.begin(), pattern.begin() + std::min(psize * psize - 1, 6U));
+    time_kernel(out, "permut_pattern_rank", psize, n_states, [&] {
+        uint64_t checksum = 0;
+        for (auto state : states) {
+            checksum += puzzle::permut_pattern_rank<psize>(puzzle::permut_fields<psize>(state), tiles.data(), tiles.size());
+        }
+        return checksum;
+    });
+}
+
+}  // namespace bench
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace bench {
+
+// rows of named values written as csv (a header line whenever the columns change) or as json lines
+class report {
+public:
+    using value = std::variant<std::string, double, uint64_t>;
+    using fields = std::vector<std::pair<std::string_view, value>>;
+
+private:
+    std::ostream& out;
+    bool json;
+    std::string header;
+
+    void write_value(const value& v) {
+        if (const auto* text = std::get_if<std::string>(&v)) {
+            if (json) {
+                out << '"' << *text << '"';
+            } else {
+                out << *text;
+            }
+        } else if (const auto* real = std::get_if<double>(&v)) {
+            out << *real;
+        } else {
+            out << std::get<uint64_t>(v);
+        }
+    }
+
+public:
+    report(std::ostream& out, bool json) : out(out), json(json) {}
+
+    void row(std::string_view kind, const fields& values) {
+        if (json) {
+            out << "{\"kind\":\"" << kind << '"';
+            for (const auto& [name, v] : values) {
+                out << ",\"" << name << "\":";
+                write_value(v);
+            }
+            out << "}\n";
+            return;
+        }
+        std::string row_header = "kind";
+        for (const auto& [name, v] : values) {
+            row_header += ',';
+            row_header += name;
+        }
+        if (row_header != header) {
+            header = std::move(row_header);
+            out << header << '\n';
+        }
+        out << kind;
+        for (const auto& [name, v] : values) {
+            out << ',';
+            write_value(v);
+        }
+        out << '\n';
+    }
+};
+
+}  // namespace bench
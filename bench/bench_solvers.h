@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_anytime.h"
+#include "15puzzle_bidirectional.h"
+#include "15puzzle_distance_table.h"
+#include "15puzzle_frontier.h"
+#include "15puzzle_hda.h"
+#include "15puzzle_memory_bounded.h"
+#include "15puzzle_solver.h"
+#include "15puzzle_walking_distance.h"
+#include "bench_report.h"
+
+namespace bench {
+
+// boards in the permut_write layout, the whole set is rejected if one of them is invalid or unsolvable
+template <uint32_t psize>
+std::vector<puzzle::permut_type> read_instances(const std::string& path) {
+    std::ifstream input(path);
+    if (!input) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    std::vector<puzzle::permut_type> instances;
+    while (true) {
+        const puzzle::permut_type permut = puzzle::permut_read<psize>(input);
+        if (permut == 0) {
+            break;
+        }
+        if (!puzzle::permut_solvable<psize>(permut)) {
+            throw std::runtime_error(path + ": instance " + std::to_string(instances.size()) + " is not solvable");
+        }
+        instances.push_back(permut);
+    }
+    if (!input.eof()) {
+        throw std::runtime_error(path + ": invalid instance " + std::to_string(instances.size()));
+    }
+    return instances;
+}
+
+// Korf's layout, one board per line: an optional instance number, then the fields row by row with 0 the empty field and the goal
+// 0 1 ... 15; turned by 180 degrees that goal is permut_goal, and every solution keeps its length
+template <uint32_t psize>
+std::vector<puzzle::permut_type> read_instances_korf(const std::string& path) {
+    constexpr uint32_t n_fields = psize * psize;
+    std::ifstream input(path);
+    if (!input) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    std::vector<puzzle::permut_type> instances;
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        std::vector<uint32_t> values;
+        for (uint32_t value; fields >> value;) {
+            values.push_back(value);
+        }
+        if (values.empty() && fields.eof()) {
+            continue;
+        }
+        if (values.size() == n_fields + 1) {
+            values.erase(values.begin());
+        }
+        std::array<uint32_t, n_fields> arr;
+        uint32_t seen = 0;
+        bool valid = fields.eof() && values.size() == n_fields;
+        for (uint32_t field = 0; valid && field < n_fields; ++field) {
+            valid = values[field] < n_fields && (seen & (1U << values[field])) == 0;
+            if (valid) {
+                seen |= 1U << values[field];
+                arr[n_fields - 1 - field] = values[field] == 0 ? n_fields - 1 : n_fields - 1 - values[field];
+            }
+        }
+        if (!valid) {
+            throw std::runtime_error(path + ": invalid instance " + std::to_string(instances.size()));
+        }
+        const puzzle::permut_type permut = puzzle::permut_create<psize>(arr);
+        if (!puzzle::permut_solvable<psize>(permut)) {
+            throw std::runtime_error(path + ": instance " + std::to_string(instances.size()) + " is not solvable");
+        }
+        instances.push_back(permut);
+    }
+    return instances;
+}
+
+// VmHWM is reset to the current rss by writing 5 to clear_refs, both report 0 where /proc is missing
+inline void reset_peak_rss() {
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+inline uint64_t peak_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        if (key == "VmHWM:") {
+            uint64_t kb = 0;
+            status >> kb;
+            return kb;
+        }
+    }
+    return 0;
+}
+
+struct solver_variant {
+    std::string name;
+    std::function<std::optional<puzzle::solution>(puzzle::permut_type)> solve;
+};
+
+template <uint32_t psize>
+std::vector<solver_variant> solver_variants() {
+    const puzzle::linear_conflict_heuristic<psize> lc;
+    // the tables are built here, before the timed solves
+    const puzzle::walking_distance_heuristic<psize> wd;
+    const puzzle::walking_distance_wlc_heuristic<psize> wd_lc;
+    std::vector<solver_variant> variants = {
+        {"find_solution/heap", [](puzzle::permut_type p) { return puzzle::find_solution<psize>(p, puzzle::manhattan_dist_wlc<psize>); }},
+        {"find_solution/bucket", [](puzzle::permut_type p) { return puzzle::find_solution<psize, decltype(&puzzle::manhattan_dist_wlc<psize>), puzzle::puzzle_bucket_queue>(p, puzzle::manhattan_dist_wlc<psize>); }},
+        {"find_solution_manhattan/heap", [](puzzle::permut_type p) { return puzzle::find_solution_manhattan<psize>(p); }},
+        {"find_solution_manhattan/bucket", [](puzzle::permut_type p) { return puzzle::find_solution_manhattan<psize, puzzle::puzzle_bucket_queue>(p); }},
+        {"find_solution_manhattan_wadditional/heap", [lc](puzzle::permut_type p) { return puzzle::find_solution_manhattan_wadditional<psize>(p, lc); }},
+        {"find_solution_manhattan_wadditional/bucket", [lc](puzzle::permut_type p) { return puzzle::find_solution_manhattan_wadditional<psize, decltype(lc), puzzle::puzzle_bucket_queue>(p, lc); }},
+        {"find_solution_epea/heap", [lc](puzzle::permut_type p) { return puzzle::find_solution_epea<psize>(p, lc); }},
+        {"find_solution_epea/bucket", [lc](puzzle::permut_type p) { return puzzle::find_solution_epea<psize, decltype(lc), puzzle::puzzle_bucket_queue>(p, lc); }},
+        {"find_solution/wd", [wd](puzzle::permut_type p) { return puzzle::find_solution<psize, decltype(wd), puzzle::puzzle_bucket_queue>(p, wd); }},
+        {"find_solution/wd_lc", [wd_lc](puzzle::permut_type p) { return puzzle::find_solution<psize, decltype(wd_lc), puzzle::puzzle_bucket_queue>(p, wd_lc); }},
+        {"find_solution_weighted/w2", [lc](puzzle::permut_type p) { return puzzle::find_solution_weighted<psize>(p, lc, 2.0); }},
+        {"find_solution_bidirectional", [](puzzle::permut_type p) { return puzzle::find_solution_bidirectional<psize>(p); }},
+        {"find_solution_frontier", [](puzzle::permut_type p) { return puzzle::find_solution_frontier<psize>(p); }},
+        {"find_solution_memory_bounded/1MiB", [lc](puzzle::permut_type p) {
+             puzzle::memory_limit limit{size_t{1} << 20};
+             return puzzle::find_solution_memory_bounded<psize>(p, lc, limit);
+         }},
+    };
+    // one core per thread is needed before these show a speedup
+    for (size_t n_threads : {1, 2, 4, 8, 16}) {
+        variants.push_back({"find_solution_hda/" + std::to_string(n_threads),
+                            [lc, n_threads](puzzle::permut_type p) { return puzzle::find_solution_hda<psize>(p, lc, n_threads); }});
+    }
+    if constexpr (psize == 3) {
+        // built once outside the timed solves
+        const auto table = std::make_shared<const puzzle::distance_table<psize>>(puzzle::distance_table<psize>::generate());
+        variants.push_back({"distance_table", [table](puzzle::permut_type p) { return table->solve(p); }});
+    }
+    return variants;
+}
+
+// every variant on every instance with a fresh queue, one row per solve and then a summary row per variant
+template <uint32_t psize>
+void bench_solvers(report& out, std::string_view set_name, const std::vector<puzzle::permut_type>& instances) {
+    std::vector<report::fields> summaries;
+    for (const solver_variant& variant : solver_variants<psize>()) {
+        double total_seconds = 0;
+        uint64_t total_processed = 0;
+        uint64_t total_touched = 0;
+        uint64_t max_rss_kb = 0;
+        for (size_t id = 0; id < instances.size(); ++id) {
+            reset_peak_rss();
+            const auto start = std::chrono::steady_clock::now();
+            const auto sol = variant.solve(instances[id]);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            const uint64_t rss_kb = peak_rss_kb();
+            const uint64_t processed = sol ? sol->processed : 0;
+            const uint64_t touched = sol ? sol->touched : 0;
+            out.row("solve", {{"set", std::string(set_name)},
+                              {"solver", variant.name},
+                              {"id", uint64_t{id}},
+                              {"steps", uint64_t{sol ? sol->steps.size() - 1 : 0}},
+                              {"processed", processed},
+                              {"touched", touched},
+                              {"seconds", seconds},
+                              {"nodes_per_s", processed / seconds},
+                              {"peak_rss_kb", rss_kb}});
+            total_seconds += seconds;
+            total_processed += processed;
+            total_touched += touched;
+            max_rss_kb = std::max(max_rss_kb, rss_kb);
+        }
+        summaries.push_back({{"set", std::string(set_name)},
+                             {"solver", variant.name},
+                             {"instances", uint64_t{instances.size()}},
+                             {"processed", total_processed},
+                             {"touched", total_touched},
+                             {"seconds", total_seconds},
+                             {"nodes_per_s", total_processed / total_seconds},
+                             {"peak_rss_kb", max_rss_kb}});
+    }
+    for (const report::fields& summary : summaries) {
+        out.row("summary", summary);
+    }
+}
+
+}  // namespace bench
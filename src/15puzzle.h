@@ -6,47 +6,93 @@
 #include <initializer_list>
 #include <iomanip>
 #include <iostream>
+#include <numeric>
 #include <string>
+#include <type_traits>
 
 namespace puzzle {
+// board of the 3x3 and 4x4 puzzles
 using permut_type = uint64_t;
 using dist_type = uint8_t;
 
+__extension__ typedef unsigned __int128 uint128_type;
+
+// packed board, the first field sits in the highest bits, boards that do not fit into 64 bits use a 128 bit word
+template <uint32_t psize>
+struct permut_traits {
+    static constexpr int offset = std::bit_width(psize * psize - 1);
+    static_assert(psize * psize * offset <= 128, "the board has to fit into 128 bits");
+    using type = std::conditional_t<(psize * psize * offset <= 64), uint64_t, uint128_type>;
+};
+
+template <uint32_t psize>
+using permut_t = typename permut_traits<psize>::type;
+
+// std::countr_zero and std::bit_width for both board words, unsigned __int128 is no standard integer type
+constexpr int permut_countr_zero(uint64_t p) {
+    return std::countr_zero(p);
+}
+
+constexpr int permut_countr_zero(uint128_type p) {
+    const uint64_t low = static_cast<uint64_t>(p);
+    return low != 0 ? std::countr_zero(low) : 64 + std::countr_zero(static_cast<uint64_t>(p >> 64));
+}
+
+constexpr int permut_bit_width(uint64_t p) {
+    return std::bit_width(p);
+}
+
+constexpr int permut_bit_width(uint128_type p) {
+    const uint64_t high = static_cast<uint64_t>(p >> 64);
+    return high != 0 ? 64 + std::bit_width(high) : std::bit_width(static_cast<uint64_t>(p));
+}
+
+template <uint32_t n>
+constexpr std::array<uint32_t, n> tiles_in_order() {
+    std::array<uint32_t, n> arr{};
+    std::iota(arr.begin(), arr.end(), 0);
+    return arr;
+}
+
 template <uint32_t psize>
-constexpr permut_type permut_create_from_partial(const std::array<uint32_t, psize * psize - 1>& arr) {
+constexpr permut_t<psize> permut_create_from_partial(const std::array<uint32_t, psize * psize - 1>& arr) {
     constexpr auto offset = std::bit_width(psize * psize - 1);
-    permut_type ret_p = 0;
+    permut_t<psize> ret_p = 0;
     for (auto e : arr) {
         ret_p <<= offset;
-        ret_p |= static_cast<permut_type>(e);
+        ret_p |= static_cast<permut_t<psize>>(e);
     }
     ret_p <<= offset;
-    ret_p |= static_cast<permut_type>(psize * psize - 1);
+    ret_p |= static_cast<permut_t<psize>>(psize * psize - 1);
     return ret_p;
 }
 
 template <uint32_t psize>
-constexpr permut_type permut_create(const std::array<uint32_t, psize * psize>& arr) {
+constexpr permut_t<psize> permut_create(const std::array<uint32_t, psize * psize>& arr) {
     constexpr auto offset = std::bit_width(psize * psize - 1);
-    permut_type ret_p = 0;
+    permut_t<psize> ret_p = 0;
     for (auto e : arr) {
         ret_p <<= offset;
-        ret_p |= static_cast<permut_type>(e);
+        ret_p |= static_cast<permut_t<psize>>(e);
     }
     return ret_p;
 }
 
 template <uint32_t psize>
-constexpr permut_type permut_create(std::initializer_list<uint32_t> p) {
+constexpr permut_t<psize> permut_create(std::initializer_list<uint32_t> p) {
     constexpr auto offset = std::bit_width(psize * psize - 1);
-    permut_type ret_p = 0;
+    permut_t<psize> ret_p = 0;
     for (auto e : p) {
         ret_p <<= offset;
-        ret_p |= static_cast<permut_type>(e);
+        ret_p |= static_cast<permut_t<psize>>(e);
     }
     return ret_p;
 }
 
+// tiles in order with the empty field in the lower right corner
+template <uint32_t psize>
+inline constexpr permut_t<psize> permut_goal = permut_create<psize>(tiles_in_order<psize * psize>());
+
 template <uint32_t array_size>
 constexpr bool parity_check(const std::array<unsigned, array_size>& arr) {
     size_t inv_count = 0;
@@ -60,17 +106,20 @@ constexpr bool parity_check(const std::array<unsigned, array_size>& arr) {
     return inv_count % 2 == 0;
 }
 
+// reads the permut_write layout (0 is the empty field), returns 0 on a read error or an invalid board
 template <uint32_t psize>
-permut_type permut_read(std::istream& stream) {
+permut_t<psize> permut_read(std::istream& stream) {
     std::array<uint32_t, psize * psize> arr;
+    uint32_t seen = 0;
     for (uint32_t i = 0; i < psize * psize; ++i) {
-        if (!stream >> arr[i]) {
+        if (!(stream >> arr[i]) || arr[i] >= psize * psize || (seen & (1U << arr[i]))) {
             return 0;
         }
-        arr[i] += (psize - 1);
-        arr[i] %= psize;
+        seen |= 1U << arr[i];
+        arr[i] += (psize * psize - 1);
+        arr[i] %= psize * psize;
     }
-    return permut_create(arr);
+    return permut_create<psize>(arr);
 }
 
 template <uint32_t psize>
@@ -79,7 +128,7 @@ bool permut_check(const std::array<unsigned, psize * psize>& arr) {
 }
 
 template <uint32_t psize>
-std::array<uint32_t, psize * psize> permut_to_array(permut_type p) {
+std::array<uint32_t, psize * psize> permut_to_array(permut_t<psize> p) {
     static constexpr int offset = std::bit_width(psize * psize - 1);
     static constexpr uint32_t mask = ~(~0U << offset);
     std::array<uint32_t, psize* psize> ret_arr = {};
@@ -90,8 +139,20 @@ std::array<uint32_t, psize * psize> permut_to_array(permut_type p) {
     return ret_arr;
 }
 
+// the empty field has to travel as many fields as the permutation parity needs transpositions
+template <uint32_t psize>
+bool permut_solvable(permut_t<psize> permut) {
+    const auto arr = permut_to_array<psize>(permut);
+    uint32_t empty_pozz = 0;
+    while (arr[empty_pozz] != psize * psize - 1) {
+        ++empty_pozz;
+    }
+    const uint32_t empty_dist = (psize - 1 - empty_pozz / psize) + (psize - 1 - empty_pozz % psize);
+    return parity_check<psize * psize>(arr) == (empty_dist % 2 == 0);
+}
+
 template <uint32_t psize>
-std::ostream& permut_write(std::ostream& stream, permut_type permut, int width = 2) {
+std::ostream& permut_write(std::ostream& stream, permut_t<psize> permut, int width = 2) {
     const auto arr = puzzle::permut_to_array<psize>(permut);
     for (size_t i = 0; i < psize * psize; ++i) {
         stream << std::setw(width) << (arr[i] + 1) % (psize * psize);
@@ -105,32 +166,36 @@ inline dist_type manhattan_dist_winfo(dist_type a, int info) {
     return info > 0 ? ++a : --a;
 }
 
+// distance of every tile from its goal field, [tile][field], the empty field counts 0
 template <uint32_t psize>
-constexpr dist_type manhattan_dist(permut_type a) {
-    constexpr int offset = std::bit_width(psize * psize - 1);
-    constexpr uint32_t mask = ~(~0U << offset);
-    constexpr auto diff = [](uint32_t a, uint32_t b) -> uint32_t {
+inline constexpr auto manhattan_table = [] {
+    constexpr auto diff = [](uint32_t a, uint32_t b) -> dist_type {
         return a > b ? a - b : b - a;
     };
+    std::array<std::array<dist_type, psize * psize>, psize * psize> table{};
+    for (uint32_t tile = 0; tile < psize * psize - 1; ++tile) {
+        for (uint32_t pozz = 0; pozz < psize * psize; ++pozz) {
+            table[tile][pozz] = diff(pozz / psize, tile / psize) + diff(pozz % psize, tile % psize);
+        }
+    }
+    return table;
+}();
+
+template <uint32_t psize>
+constexpr dist_type manhattan_dist(permut_t<psize> a) {
+    constexpr int offset = std::bit_width(psize * psize - 1);
+    constexpr uint32_t mask = ~(~0U << offset);
     dist_type dist = 0;
     for (uint32_t pozz = psize * psize - 1; pozz != static_cast<uint32_t>(-1); --pozz) {
-        auto temp = a & mask;
-        if (temp != psize * psize - 1) {
-            auto pozz_row = pozz / psize;
-            auto pozz_col = pozz % psize;
-            auto temp_row = temp / psize;
-            auto temp_col = temp % psize;
-            dist += diff(pozz_row, temp_row);
-            dist += diff(pozz_col, temp_col);
-        }
+        dist += manhattan_table<psize>[a & mask][pozz];
         a >>= offset;
     }
     return dist;
 }
 
+// conflicts of one line, key[i] is the goal position along the line of the tile on field i or psize if it belongs elsewhere
 template <uint32_t psize>
-constexpr dist_type linear_conflict(permut_type a) {
-    constexpr uint32_t empty = psize * psize - 1;
+constexpr dist_type line_conflict(const std::array<uint32_t, psize>& key) {
     auto find_max_nonzero = [](const std::array<int, psize>& arr) {
         size_t max_pos = psize;
         int max_val = 1;
@@ -142,77 +207,208 @@ constexpr dist_type linear_conflict(permut_type a) {
         }
         return max_pos;
     };
-    const auto permut_array = permut_to_array<psize>(a);
+    std::array<int, psize> n_tiles_in_conflict{};
+    for (size_t first = 0; first < psize - 1; ++first) {
+        for (size_t other = first + 1; other < psize && key[first] != psize; ++other) {
+            if (key[other] != psize && key[first] > key[other]) {
+                ++n_tiles_in_conflict[first];
+            }
+        }
+    }
     dist_type lc_value = 0;
-    for (size_t first = 0; first < psize; ++first) {
-        std::array<int, psize> n_tiles_in_conflict_row{};
-        std::array<int, psize> n_tiles_in_conflict_col{};
-        for (size_t second = 0; second < psize - 1; ++second) {
-            auto start_tile_row = permut_array[first * psize + second];
-            if (start_tile_row != empty && start_tile_row < (first + 1) * psize && start_tile_row >= first * psize) {
-                for (size_t other = second + 1; other < psize; ++other) {
-                    auto other_tile_row = permut_array[first * psize + other];
-                    if (other_tile_row != empty && start_tile_row > other_tile_row &&
-                        other_tile_row < (first + 1) * psize && other_tile_row >= first * psize) {
-                        ++n_tiles_in_conflict_row[second];
-                    }
-                }
+    // greedily takes the tile with the most conflicts out of the line
+    size_t nonzero_pos = find_max_nonzero(n_tiles_in_conflict);
+    while (nonzero_pos < psize) {
+        n_tiles_in_conflict[nonzero_pos] = 0;
+        for (size_t other = nonzero_pos + 1; other < psize; ++other) {
+            if (key[other] != psize && key[nonzero_pos] > key[other]) {
+                --n_tiles_in_conflict[other];
             }
-            auto start_tile_col = permut_array[second * psize + first];
-            if (start_tile_col != empty && start_tile_col % psize == first) {
-                for (size_t other = second + 1; other < psize; ++other) {
-                    auto other_tile_col = permut_array[other * psize + first];
-                    if (other_tile_col != empty && start_tile_col > other_tile_col && other_tile_col % psize == first) {
-                        ++n_tiles_in_conflict_col[second];
-                    }
+        }
+        ++lc_value;
+        nonzero_pos = find_max_nonzero(n_tiles_in_conflict);
+    }
+    return lc_value * 2;
+}
+
+// line conflicts for every line content, a line is indexed by its keys as digits in base psize + 1
+template <uint32_t psize>
+struct linear_conflict_tables {
+    static constexpr uint32_t radix = psize + 1;
+    static constexpr uint32_t n_lines = [] {
+        uint32_t n = 1;
+        for (uint32_t i = 0; i < psize; ++i) {
+            n *= radix;
+        }
+        return n;
+    }();
+
+    // [line][field along the line][tile] -> key already multiplied by its digit weight
+    std::array<std::array<std::array<uint16_t, psize * psize>, psize>, psize> row_digit{};
+    std::array<std::array<std::array<uint16_t, psize * psize>, psize>, psize> col_digit{};
+    // the same for two neighbouring fields at once, [line][pair][tile of field 2 * pair << 4 | tile of field 2 * pair + 1]
+    std::array<std::array<std::array<uint16_t, 256>, (psize + 1) / 2>, psize> row_pair{};
+    std::array<std::array<std::array<uint16_t, 256>, (psize + 1) / 2>, psize> col_pair{};
+    std::array<dist_type, n_lines> conflicts{};
+
+    constexpr linear_conflict_tables() : linear_conflict_tables(tiles_in_order<psize * psize>()) {}
+    // conflicts towards any board, goal_field[tile] is the field the tile belongs to
+    template <typename Field>
+    constexpr explicit linear_conflict_tables(const std::array<Field, psize * psize>& goal_field) {
+        constexpr uint32_t empty = psize * psize - 1;
+        for (uint32_t line = 0; line < psize; ++line) {
+            uint32_t weight = n_lines;
+            for (uint32_t field = 0; field < psize; ++field) {
+                weight /= radix;
+                for (uint32_t tile = 0; tile < psize * psize; ++tile) {
+                    const uint32_t row_key = tile != empty && goal_field[tile] / psize == line ? goal_field[tile] % psize : psize;
+                    const uint32_t col_key = tile != empty && goal_field[tile] % psize == line ? goal_field[tile] / psize : psize;
+                    row_digit[line][field][tile] = row_key * weight;
+                    col_digit[line][field][tile] = col_key * weight;
                 }
             }
         }
-        {
-            size_t nonzero_pos = find_max_nonzero(n_tiles_in_conflict_row);
-            while (nonzero_pos < psize) {
-                n_tiles_in_conflict_row[nonzero_pos] = 0;
-                auto nonzero_tile = permut_array[first * psize + nonzero_pos];
-                for (size_t other = nonzero_pos + 1; other < psize; ++other) {
-                    auto other_tile_col = permut_array[first * psize + other];
-                    if (other_tile_col != empty && nonzero_tile > other_tile_col &&
-                        other_tile_col < (first + 1) * psize && other_tile_col >= first * psize) {
-                        --n_tiles_in_conflict_row[other];
+        for (uint32_t line = 0; line < psize; ++line) {
+            for (uint32_t pair = 0; pair < (psize + 1) / 2; ++pair) {
+                for (uint32_t tiles = 0; tiles < 256 && 2 * pair + 1 < psize; ++tiles) {
+                    const uint32_t first = tiles >> 4;
+                    const uint32_t second = tiles & 0xf;
+                    if (first < psize * psize && second < psize * psize) {
+                        row_pair[line][pair][tiles] = row_digit[line][2 * pair][first] + row_digit[line][2 * pair + 1][second];
+                        col_pair[line][pair][tiles] = col_digit[line][2 * pair][first] + col_digit[line][2 * pair + 1][second];
                     }
                 }
-                ++lc_value;
-                nonzero_pos = find_max_nonzero(n_tiles_in_conflict_row);
             }
         }
-        {
-            size_t nonzero_pos = find_max_nonzero(n_tiles_in_conflict_col);
-            while (nonzero_pos < psize) {
-                n_tiles_in_conflict_col[nonzero_pos] = 0;
-                auto nonzero_tile = permut_array[nonzero_pos * psize + first];
-                for (size_t other = nonzero_pos + 1; other < psize; ++other) {
-                    auto other_tile = permut_array[other * psize + first];
-                    if (other_tile != empty && nonzero_tile > other_tile && other_tile % psize == first) {
-                        --n_tiles_in_conflict_col[other];
-                    }
-                }
-                ++lc_value;
-                nonzero_pos = find_max_nonzero(n_tiles_in_conflict_col);
+        for (uint32_t index = 0; index < n_lines; ++index) {
+            std::array<uint32_t, psize> key{};
+            uint32_t rest = index;
+            for (uint32_t field = psize; field-- > 0;) {
+                key[field] = rest % radix;
+                rest /= radix;
             }
+            conflicts[index] = line_conflict<psize>(key);
         }
     }
-    return lc_value * 2;
+};
+
+template <uint32_t psize>
+inline constexpr linear_conflict_tables<psize> lc_tables{};
+
+template <uint32_t psize>
+constexpr dist_type row_conflict(const linear_conflict_tables<psize>& tables, permut_t<psize> a, uint32_t row) {
+    constexpr int offset = std::bit_width(psize * psize - 1);
+    constexpr permut_t<psize> mask = ~(~0U << offset);
+    if constexpr (psize == 4) {
+        // a row is one 16 bit word
+        const uint32_t line = (a >> ((psize - 1 - row) * 16)) & 0xffff;
+        return tables.conflicts[tables.row_pair[row][0][line >> 8] + tables.row_pair[row][1][line & 0xff]];
+    }
+    uint32_t index = 0;
+    for (uint32_t field = 0; field < psize; ++field) {
+        const int field_offset = (psize * psize - 1 - (row * psize + field)) * offset;
+        index += tables.row_digit[row][field][(a >> field_offset) & mask];
+    }
+    return tables.conflicts[index];
+}
+
+template <uint32_t psize>
+constexpr dist_type col_conflict(const linear_conflict_tables<psize>& tables, permut_t<psize> a, uint32_t col) {
+    constexpr int offset = std::bit_width(psize * psize - 1);
+    constexpr permut_t<psize> mask = ~(~0U << offset);
+    if constexpr (psize == 4) {
+        // the column nibbles sit 16 bits apart, folding them pairs rows 0 and 1 in bits 32 to 39 and rows 2 and 3 in bits 0 to 7
+        permut_t<psize> line = (a >> ((psize - 1 - col) * 4)) & 0x000f000f000f000fULL;
+        line |= line >> 12;
+        return tables.conflicts[tables.col_pair[col][0][(line >> 32) & 0xff] + tables.col_pair[col][1][line & 0xff]];
+    }
+    uint32_t index = 0;
+    for (uint32_t field = 0; field < psize; ++field) {
+        const int field_offset = (psize * psize - 1 - (field * psize + col)) * offset;
+        index += tables.col_digit[col][field][(a >> field_offset) & mask];
+    }
+    return tables.conflicts[index];
 }
 
 template <uint32_t psize>
-constexpr dist_type manhattan_dist_wlc(permut_type a) {
+constexpr dist_type row_conflict(permut_t<psize> a, uint32_t row) {
+    return row_conflict<psize>(lc_tables<psize>, a, row);
+}
+
+template <uint32_t psize>
+constexpr dist_type col_conflict(permut_t<psize> a, uint32_t col) {
+    return col_conflict<psize>(lc_tables<psize>, a, col);
+}
+
+template <uint32_t psize>
+constexpr dist_type linear_conflict(const linear_conflict_tables<psize>& tables, permut_t<psize> a) {
+    dist_type lc_value = 0;
+    for (uint32_t line = 0; line < psize; ++line) {
+        lc_value += row_conflict<psize>(tables, a, line) + col_conflict<psize>(tables, a, line);
+    }
+    return lc_value;
+}
+
+template <uint32_t psize>
+constexpr dist_type linear_conflict(permut_t<psize> a) {
+    return linear_conflict<psize>(lc_tables<psize>, a);
+}
+
+// linear conflict of to = from with one move applied, a vertical move only changes two rows and a horizontal one two columns
+template <uint32_t psize>
+constexpr dist_type linear_conflict_update(const linear_conflict_tables<psize>& tables, permut_t<psize> from, permut_t<psize> to, dist_type from_value) {
+    constexpr int offset = std::bit_width(psize * psize - 1);
+    const permut_t<psize> changed = from ^ to;
+    const uint32_t low_field = psize * psize - 1 - permut_countr_zero(changed) / offset;
+    const uint32_t high_field = psize * psize - 1 - (permut_bit_width(changed) - 1) / offset;
+    if (low_field - high_field != 1) {
+        const uint32_t low_row = low_field / psize;
+        const uint32_t high_row = high_field / psize;
+        return from_value - row_conflict<psize>(tables, from, low_row) - row_conflict<psize>(tables, from, high_row) + row_conflict<psize>(tables, to, low_row) +
+               row_conflict<psize>(tables, to, high_row);
+    }
+    const uint32_t low_col = low_field % psize;
+    const uint32_t high_col = high_field % psize;
+    return from_value - col_conflict<psize>(tables, from, low_col) - col_conflict<psize>(tables, from, high_col) + col_conflict<psize>(tables, to, low_col) +
+           col_conflict<psize>(tables, to, high_col);
+}
+
+template <uint32_t psize>
+constexpr dist_type linear_conflict_update(permut_t<psize> from, permut_t<psize> to, dist_type from_value) {
+    return linear_conflict_update<psize>(lc_tables<psize>, from, to, from_value);
+}
+
+// linear_conflict as a heuristic the solvers can update per move
+template <uint32_t psize>
+struct linear_conflict_heuristic {
+    dist_type operator()(permut_t<psize> a) const {
+        return linear_conflict<psize>(a);
+    }
+    dist_type update(permut_t<psize> from, permut_t<psize> to, dist_type from_value) const {
+        return linear_conflict_update<psize>(from, to, from_value);
+    }
+};
+
+// value of the heuristic for to, one move away from from, heuristics with an update member recompute only what the move changed
+template <typename Heuristic, typename Permut>
+dist_type heuristic_update(Heuristic& heuristic, Permut from, Permut to, dist_type from_value) {
+    if constexpr (requires { heuristic.update(from, to, from_value); }) {
+        return heuristic.update(from, to, from_value);
+    } else {
+        return heuristic(to);
+    }
+}
+
+template <uint32_t psize>
+constexpr dist_type manhattan_dist_wlc(permut_t<psize> a) {
     return manhattan_dist<psize>(a) + linear_conflict<psize>(a);
 }
 
 template <uint32_t psize>
-constexpr int find_empty(permut_type permut) {
+constexpr int find_empty(permut_t<psize> permut) {
     constexpr int offset = std::bit_width(psize * psize - 1);
-    constexpr permut_type mask = ~(~0U << offset);
-    constexpr permut_type empty = psize * psize - 1;
+    constexpr permut_t<psize> mask = ~(~0U << offset);
+    constexpr permut_t<psize> empty = psize * psize - 1;
     int empty_offset = 0;
     while ((permut & mask) != empty) {
         empty_offset += offset;
@@ -221,24 +417,88 @@ constexpr int find_empty(permut_type permut) {
     return empty_offset;
 }
 
+// direction in which the tile slides into the empty field
+enum move_dir : uint8_t {
+    move_down = 0,
+    move_left = 1,
+    move_up = 2,
+    move_right = 3,
+    // parent move of the initial permutation
+    move_none = 4,
+};
+
+constexpr move_dir move_opposite(move_dir dir) {
+    return static_cast<move_dir>(dir ^ 2);
+}
+
+template <uint32_t psize>
+constexpr move_dir permut_move_between(permut_t<psize> from, permut_t<psize> to) {
+    constexpr int offset = std::bit_width(psize * psize - 1);
+    constexpr permut_t<psize> mask = ~(~0U << offset);
+    constexpr permut_t<psize> empty = psize * psize - 1;
+    const permut_t<psize> changed = from ^ to;
+    const int low_offset = permut_countr_zero(changed) / offset * offset;
+    const int high_offset = (permut_bit_width(changed) - 1) / offset * offset;
+    const bool vertical = high_offset - low_offset != offset;
+    // the tile ends up on the field with the lower offset (later index) when it moves down or right
+    if (((to >> high_offset) & mask) == empty) {
+        return vertical ? move_down : move_right;
+    }
+    return vertical ? move_up : move_left;
+}
+
+template <uint32_t psize>
+constexpr permut_t<psize> permut_undo_move(permut_t<psize> permut, move_dir dir) {
+    constexpr int offset = std::bit_width(psize * psize - 1);
+    constexpr permut_t<psize> mask = ~(~0U << offset);
+    const int empty_offset = find_empty<psize>(permut);
+    int tile_offset = empty_offset;
+    switch (dir) {
+        case move_down:
+            tile_offset -= psize * offset;
+            break;
+        case move_right:
+            tile_offset -= offset;
+            break;
+        case move_up:
+            tile_offset += psize * offset;
+            break;
+        case move_left:
+            tile_offset += offset;
+            break;
+        case move_none:
+            return permut;
+    }
+    const permut_t<psize> tile = (permut >> tile_offset) & mask;
+    const permut_t<psize> empty = (permut >> empty_offset) & mask;
+    permut &= ~((mask << tile_offset) | (mask << empty_offset));
+    return permut | (tile << empty_offset) | (empty << tile_offset);
+}
+
+// the board after the tile slides in direction dir, the inverse of permut_undo_move
+template <uint32_t psize>
+constexpr permut_t<psize> permut_apply_move(permut_t<psize> permut, move_dir dir) {
+    return dir == move_none ? permut : permut_undo_move<psize>(permut, move_opposite(dir));
+}
+
 template <uint32_t psize>
 class permut_neighbors_itr_winfo {
-    std::pair<permut_type, int> neighbors[4];
+    std::pair<permut_t<psize>, int> neighbors[4];
     unsigned len = 0;
 
 public:
-    explicit permut_neighbors_itr_winfo(permut_type permut) {
+    explicit permut_neighbors_itr_winfo(permut_t<psize> permut) {
         static constexpr int offset = std::bit_width(psize * psize - 1);
-        static constexpr permut_type mask = ~(~0U << offset);
+        static constexpr permut_t<psize> mask = ~(~0U << offset);
         static constexpr int max_offset = (psize * psize - 1) * offset;
         const int empty_offset = find_empty<psize>(permut);
-        const permut_type clean_mask = mask << empty_offset;
-        const permut_type empty = permut & clean_mask;
-        const permut_type clean_permut = permut & ~clean_mask;
+        const permut_t<psize> clean_mask = mask << empty_offset;
+        const permut_t<psize> empty = permut & clean_mask;
+        const permut_t<psize> clean_permut = permut & ~clean_mask;
         // shift down
         if (int curr_offset = empty_offset + psize * offset; curr_offset <= max_offset) {
-            permut_type curr_mask = mask << curr_offset;
-            permut_type curr_tile = (clean_permut & curr_mask);
+            permut_t<psize> curr_mask = mask << curr_offset;
+            permut_t<psize> curr_tile = (clean_permut & curr_mask);
             neighbors[len].first = (curr_tile >> (curr_offset - empty_offset)) | (clean_permut & ~curr_mask);
             neighbors[len].first |= (empty << (curr_offset - empty_offset));
             curr_tile >>= curr_offset;
@@ -249,8 +509,8 @@ public:
         }
         // shift left
         if (int curr_offset = empty_offset - offset; curr_offset >= 0 && empty_offset / (psize * offset) == curr_offset / (psize * offset)) {
-            permut_type curr_mask = mask << curr_offset;
-            permut_type curr_tile = (clean_permut & curr_mask);
+            permut_t<psize> curr_mask = mask << curr_offset;
+            permut_t<psize> curr_tile = (clean_permut & curr_mask);
             neighbors[len].first = (curr_tile << offset) | (clean_permut & ~curr_mask);
             neighbors[len].first |= (empty >> offset);
             curr_tile >>= curr_offset;
@@ -261,8 +521,8 @@ public:
         }
         // shift up
         if (int curr_offset = empty_offset - psize * offset; curr_offset >= 0) {
-            permut_type curr_mask = mask << curr_offset;
-            permut_type curr_tile = (clean_permut & curr_mask);
+            permut_t<psize> curr_mask = mask << curr_offset;
+            permut_t<psize> curr_tile = (clean_permut & curr_mask);
             neighbors[len].first = (curr_tile << (empty_offset - curr_offset)) | (clean_permut & ~curr_mask);
             neighbors[len].first |= (empty >> (empty_offset - curr_offset));
             curr_tile >>= curr_offset;
@@ -273,8 +533,8 @@ public:
         }
         // shift right
         if (int curr_offset = empty_offset + offset; curr_offset <= max_offset && empty_offset / (psize * offset) == curr_offset / (psize * offset)) {
-            permut_type curr_mask = mask << curr_offset;
-            permut_type curr_tile = (clean_permut & curr_mask);
+            permut_t<psize> curr_mask = mask << curr_offset;
+            permut_t<psize> curr_tile = (clean_permut & curr_mask);
             neighbors[len].first = (curr_tile >> offset) | (clean_permut & ~curr_mask);
             neighbors[len].first |= (empty << offset);
             curr_tile >>= curr_offset;
@@ -294,47 +554,137 @@ public:
 
 template <uint32_t psize>
 class permut_neighbors_itr {
-    permut_type neighbors[4];
+    permut_t<psize> neighbors[4];
     unsigned len = 0;
 
 public:
-    explicit permut_neighbors_itr(permut_type permut) {
+    explicit permut_neighbors_itr(permut_t<psize> permut) {
         static constexpr int offset = std::bit_width(psize * psize - 1);
-        static constexpr permut_type mask = ~(~0U << offset);
+        static constexpr permut_t<psize> mask = ~(~0U << offset);
         static constexpr int max_offset = (psize * psize - 1) * offset;
         const int empty_offset = find_empty<psize>(permut);
-        const permut_type clean_mask = mask << empty_offset;
-        const permut_type empty = permut & clean_mask;
-        const permut_type clean_permut = permut & ~clean_mask;
+        const permut_t<psize> clean_mask = mask << empty_offset;
+        const permut_t<psize> empty = permut & clean_mask;
+        const permut_t<psize> clean_permut = permut & ~clean_mask;
         if (int curr_offset = empty_offset + psize * offset; curr_offset <= max_offset) {
-            permut_type curr_mask = mask << curr_offset;
+            permut_t<psize> curr_mask = mask << curr_offset;
             neighbors[len] = ((clean_permut & curr_mask) >> (curr_offset - empty_offset)) | (clean_permut & ~curr_mask);
             neighbors[len] |= (empty << (curr_offset - empty_offset));
             ++len;
         }
         if (int curr_offset = empty_offset - offset; curr_offset >= 0 && empty_offset / (psize * offset) == curr_offset / (psize * offset)) {
-            permut_type curr_mask = mask << curr_offset;
+            permut_t<psize> curr_mask = mask << curr_offset;
             neighbors[len] = ((clean_permut & curr_mask) << offset) | (clean_permut & ~curr_mask);
             neighbors[len] |= (empty >> offset);
             ++len;
         }
         if (int curr_offset = empty_offset - psize * offset; curr_offset >= 0) {
-            permut_type curr_mask = mask << curr_offset;
+            permut_t<psize> curr_mask = mask << curr_offset;
             neighbors[len] = ((clean_permut & curr_mask) << (empty_offset - curr_offset)) | (clean_permut & ~curr_mask);
             neighbors[len] |= (empty >> (empty_offset - curr_offset));
             ++len;
         }
         if (int curr_offset = empty_offset + offset; curr_offset <= max_offset && empty_offset / (psize * offset) == curr_offset / (psize * offset)) {
-            permut_type curr_mask = mask << curr_offset;
+            permut_t<psize> curr_mask = mask << curr_offset;
             neighbors[len] = ((clean_permut & curr_mask) >> offset) | (clean_permut & ~curr_mask);
             neighbors[len] |= (empty << offset);
             ++len;
         }
     }
-    permut_type* begin() {
+    permut_t<psize>* begin() {
+        return &neighbors[0];
+    }
+    permut_t<psize>* end() {
+        return &neighbors[len];
+    }
+};
+
+// field of the empty tile, fields are numbered in reading order
+template <uint32_t psize>
+constexpr uint8_t permut_blank(permut_t<psize> permut) {
+    constexpr int offset = std::bit_width(psize * psize - 1);
+    return psize * psize - 1 - find_empty<psize>(permut) / offset;
+}
+
+// a move from a board with a known empty field, the tile on tile_field slides into the empty field
+struct blank_move {
+    uint8_t tile_field;
+    uint8_t tile_offset;
+    move_dir dir;
+};
+
+struct blank_moves {
+    uint8_t empty_offset;
+    uint8_t len;
+    std::array<blank_move, 4> moves;
+};
+
+// legal moves for every field of the empty tile, in the order of permut_neighbors_itr_winfo
+template <uint32_t psize>
+inline constexpr auto move_table = [] {
+    constexpr uint32_t offset = std::bit_width(psize * psize - 1);
+    constexpr uint32_t n = psize * psize;
+    std::array<blank_moves, n> table{};
+    for (uint32_t blank = 0; blank < n; ++blank) {
+        auto& entry = table[blank];
+        entry.empty_offset = (n - 1 - blank) * offset;
+        auto add = [&](uint32_t tile_field, move_dir dir) {
+            entry.moves[entry.len++] = {static_cast<uint8_t>(tile_field), static_cast<uint8_t>((n - 1 - tile_field) * offset), dir};
+        };
+        if (blank >= psize) {
+            add(blank - psize, move_down);
+        }
+        if (blank % psize != psize - 1) {
+            add(blank + 1, move_left);
+        }
+        if (blank + psize < n) {
+            add(blank + psize, move_up);
+        }
+        if (blank % psize != 0) {
+            add(blank - 1, move_right);
+        }
+    }
+    return table;
+}();
+
+template <uint32_t psize>
+struct permut_move {
+    permut_t<psize> permut;
+    uint8_t blank;
+    move_dir dir;
+    // manhattan_dist_winfo info of the moved tile
+    int info;
+};
+
+// neighbours of a board whose empty field is known, skips the move that undoes previous
+template <uint32_t psize>
+class permut_moves_itr {
+    permut_move<psize> neighbors[4];
+    unsigned len = 0;
+
+public:
+    permut_moves_itr(permut_t<psize> permut, uint32_t blank, move_dir previous = move_none) {
+        static constexpr int offset = std::bit_width(psize * psize - 1);
+        static constexpr permut_t<psize> mask = ~(~0U << offset);
+        static constexpr permut_t<psize> empty = psize * psize - 1;
+        const blank_moves& moves = move_table<psize>[blank];
+        const move_dir undo = move_opposite(previous);
+        for (unsigned i = 0; i < moves.len; ++i) {
+            const blank_move& m = moves.moves[i];
+            if (m.dir == undo) {
+                continue;
+            }
+            const permut_t<psize> tile = (permut >> m.tile_offset) & mask;
+            const permut_t<psize> swap = tile ^ empty;
+            const auto& dist = manhattan_table<psize>[static_cast<uint32_t>(tile)];
+            neighbors[len++] = {permut ^ (swap << m.tile_offset) ^ (swap << moves.empty_offset), m.tile_field, m.dir,
+                                dist[blank] > dist[m.tile_field] ? 1 : -1};
+        }
+    }
+    permut_move<psize>* begin() {
         return &neighbors[0];
     }
-    permut_type* end() {
+    permut_move<psize>* end() {
         return &neighbors[len];
     }
 };
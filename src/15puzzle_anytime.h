@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "15puzzle.h"
+#include "15puzzle_solver.h"
+
+namespace puzzle {
+
+struct anytime_limits {
+    // weight of the first round, every round after a solution lowers it by weight_step down to 1
+    double weight = 3.0;
+    double weight_step = 0.5;
+    std::chrono::steady_clock::duration time_budget = std::chrono::steady_clock::duration::max();
+    size_t node_budget = std::numeric_limits<size_t>::max();
+};
+
+// A* on g + w * h with manhattan distance plus an additional heuristic, a goal no worse than every open node is at most w times the optimum
+template <uint32_t psize, typename Heuristic>
+class weighted_search {
+    using permut = permut_t<psize>;
+    using queue_type = puzzle_queue_t<psize>;
+    using clock = std::chrono::steady_clock;
+
+    // the clock is only read every this many expansions
+    static constexpr size_t check_every = 1024;
+
+    const permut initial;
+    Heuristic& additional;
+    queue_type& queue;
+    double weight;
+    size_t processed = 0;
+    node_index goal_index;
+
+    // keys past the range of dist_type saturate, only very large weights get there
+    dist_type weighted(uint32_t h) const noexcept {
+        return std::min<uint32_t>(weight * h, std::numeric_limits<dist_type>::max());
+    }
+
+public:
+    weighted_search(permut initial, Heuristic& additional, queue_type& queue, double weight)
+        : initial(initial), additional(additional), queue(queue), weight(weight), goal_index(queue.map_end()) {
+        queue.clear();
+        queue.push(initial, permut_blank<psize>(initial), move_none, 0, weighted(manhattan_dist<psize>(initial) + additional(initial)));
+        if (initial == permut_goal<psize>) {
+            goal_index = queue.find(initial);
+        }
+    }
+
+    // expands until the goal is no worse than the best open key, false if the open list or a budget runs out first
+    bool improve(clock::time_point deadline, size_t node_budget) {
+        constexpr permut goal = permut_goal<psize>;
+        while (!queue.empty()) {
+            const auto& current_entry = queue.node(queue.top());
+            if (goal_index != queue.map_end() && queue.node(goal_index).dist_to <= current_entry.dist_to + current_entry.dist_h) {
+                return true;
+            }
+            if (processed >= node_budget || (processed % check_every == 0 && clock::now() >= deadline)) {
+                return false;
+            }
+            ++processed;
+            queue.stats().expanded(current_entry.dist_to + current_entry.dist_h, processed, queue.map_size());
+            queue.pop();
+            const dist_type mdist = manhattan_dist<psize>(current_entry.permut);
+            const dist_type additional_dist = additional(current_entry.permut);
+            permut_moves_itr<psize> neighbours(current_entry.permut, current_entry.blank, current_entry.parent_move);
+            for (auto& n : neighbours) {
+                const uint32_t dist_new = current_entry.dist_to + 1;
+                const node_index n_index = queue.find(n.permut);
+                if (n_index != queue.map_end() && dist_new >= queue.node(n_index).dist_to) {
+                    continue;
+                }
+                const dist_type dist_h = queue.stats().heuristic([&] {
+                    return weighted(manhattan_dist_winfo<psize>(mdist, n.info) + heuristic_update(additional, current_entry.permut, n.permut, additional_dist));
+                });
+                if (n_index == queue.map_end()) {
+                    queue.push(n.permut, n.blank, n.dir, dist_new, dist_h);
+                    if (n.permut == goal) {
+                        goal_index = queue.find(goal);
+                    }
+                } else {
+                    // a node closed in an earlier round still has the key of an older weight
+                    queue.decrease_key(n_index, n.dir, dist_new, dist_h);
+                }
+            }
+        }
+        // nothing left to improve on the goal
+        return goal_index != queue.map_end();
+    }
+
+    // switches to a new weight, returns the lowest g + h over the open nodes, a lower bound on the optimum
+    uint32_t reweight(double new_weight) {
+        uint32_t lower_bound = std::numeric_limits<uint32_t>::max();
+        weight = new_weight;
+        queue.update_open([&](const auto& entry) {
+            const uint32_t h = manhattan_dist<psize>(entry.permut) + additional(entry.permut);
+            lower_bound = std::min(lower_bound, entry.dist_to + h);
+            return weighted(h);
+        });
+        return lower_bound;
+    }
+
+    solution_t<psize> solution(double bound) const {
+        return solution_t<psize>{queue.map_size(), processed, solution_steps<psize>(queue, goal_index, initial), queue.stats().counters(), bound};
+    }
+};
+
+template <uint32_t psize, typename Heuristic>
+std::optional<solution_t<psize>> find_solution_weighted(permut_t<psize> initial, Heuristic additional, double weight, puzzle_queue_t<psize>& queue) {
+    if (weight < 1.0) {
+        throw std::invalid_argument("find_solution_weighted: the weight has to be at least 1");
+    }
+    weighted_search<psize, Heuristic> search(initial, additional, queue, weight);
+    if (!search.improve(std::chrono::steady_clock::time_point::max(), std::numeric_limits<size_t>::max())) {
+        return std::nullopt;
+    }
+    return search.solution(weight);
+}
+
+template <uint32_t psize, typename Heuristic>
+std::optional<solution_t<psize>> find_solution_weighted(permut_t<psize> initial, Heuristic additional, double weight) {
+    puzzle_queue_t<psize> queue;
+    return find_solution_weighted<psize>(initial, additional, weight, queue);
+}
+
+// ARA*: weighted A* rounds with falling weights that keep the search tree, on_solution sees every better solution and the returned one
+// is the last, with solution::bound proven from the open list; stops at the budgets or once the solution is optimal
+template <uint32_t psize, typename Heuristic>
+std::optional<solution_t<psize>> find_solution_anytime(permut_t<psize> initial, Heuristic additional, const anytime_limits& limits, puzzle_queue_t<psize>& queue,
+                                                       const std::function<void(const solution_t<psize>&)>& on_solution = {}) {
+    if (limits.weight < 1.0 || limits.weight_step <= 0.0) {
+        throw std::invalid_argument("find_solution_anytime: the weight has to be at least 1 and fall every round");
+    }
+    using clock = std::chrono::steady_clock;
+    const clock::time_point start = clock::now();
+    const clock::time_point deadline = limits.time_budget >= clock::time_point::max() - start ? clock::time_point::max() : start + limits.time_budget;
+    weighted_search<psize, Heuristic> search(initial, additional, queue, limits.weight);
+    std::optional<solution_t<psize>> best;
+    double weight = limits.weight;
+    while (search.improve(deadline, limits.node_budget)) {
+        // the path rebuilt from the parent moves, not the goal's g: a re-opened ancestor can shorten it after the goal was reached, and the
+        // bound has to hold for the solution that is handed out
+        solution_t<psize> sol = search.solution(1.0);
+        const uint32_t steps = sol.steps.size() - 1;
+        const double next_weight = std::max(1.0, weight - limits.weight_step);
+        const uint32_t lower_bound = search.reweight(next_weight);
+        sol.bound = lower_bound == std::numeric_limits<uint32_t>::max() || steps <= lower_bound ? 1.0 : std::min(weight, static_cast<double>(steps) / lower_bound);
+        const double bound = sol.bound;
+        if (!best || steps + 1 < best->steps.size() || bound < best->bound) {
+            best = std::move(sol);
+            if (on_solution) {
+                on_solution(*best);
+            }
+        }
+        if (bound <= 1.0) {
+            break;
+        }
+        weight = next_weight;
+    }
+    return best;
+}
+
+template <uint32_t psize, typename Heuristic>
+std::optional<solution_t<psize>> find_solution_anytime(permut_t<psize> initial, Heuristic additional, const anytime_limits& limits,
+                                                       const std::function<void(const solution_t<psize>&)>& on_solution = {}) {
+    puzzle_queue_t<psize> queue;
+    return find_solution_anytime<psize>(initial, additional, limits, queue, on_solution);
+}
+
+}  // namespace puzzle
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace puzzle {
+
+using node_index = uint32_t;
+
+// chunked pool addressed by 32-bit indices, growing never moves nodes and the destructor frees all chunks at once
+template <typename Node, uint32_t chunk_bits = 16>
+class node_arena {
+    static constexpr uint32_t chunk_size = 1U << chunk_bits;
+    static constexpr uint32_t chunk_mask = chunk_size - 1;
+
+    std::vector<std::unique_ptr<Node[]>> chunks;
+    node_index count = 0;
+
+public:
+    // bytes of the chunks holding n nodes
+    static constexpr size_t bytes_for(size_t n) noexcept {
+        return (n + chunk_mask) / chunk_size * chunk_size * sizeof(Node);
+    }
+
+    node_index push_back(const Node& node) {
+        if ((count >> chunk_bits) == chunks.size()) {
+            chunks.push_back(std::make_unique_for_overwrite<Node[]>(chunk_size));
+        }
+        chunks[count >> chunk_bits][count & chunk_mask] = node;
+        return count++;
+    }
+
+    Node& operator[](node_index i) noexcept {
+        return chunks[i >> chunk_bits][i & chunk_mask];
+    }
+    const Node& operator[](node_index i) const noexcept {
+        return chunks[i >> chunk_bits][i & chunk_mask];
+    }
+
+    size_t size() const noexcept {
+        return count;
+    }
+
+    // keeps the chunks for the next solve
+    void clear() noexcept {
+        count = 0;
+    }
+};
+
+}  // namespace puzzle
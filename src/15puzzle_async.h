@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <utility>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_solver.h"
+#include "15puzzle_thread_pool.h"
+
+namespace puzzle {
+
+enum class solve_status {
+    solved,
+    unsolvable,
+    cancelled,
+    deadline,
+    node_budget,
+};
+
+inline const char* solve_status_name(solve_status status) noexcept {
+    switch (status) {
+        case solve_status::solved:
+            return "solved";
+        case solve_status::unsolvable:
+            return "unsolvable";
+        case solve_status::cancelled:
+            return "cancelled";
+        case solve_status::deadline:
+            return "deadline";
+        case solve_status::node_budget:
+            return "node_budget";
+    }
+    return "unknown";
+}
+
+struct solve_limits {
+    std::stop_token stop;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // counts from when the solve starts, which for a queued solve is when a worker takes it up
+    std::chrono::steady_clock::duration time_budget = std::chrono::steady_clock::duration::max();
+    size_t node_budget = std::numeric_limits<size_t>::max();
+};
+
+// the counters are filled in however the search ended, lower_bound is the optimum when solved and a bound on it otherwise
+template <uint32_t psize>
+struct solve_result {
+    solve_status status;
+    std::optional<solution_t<psize>> solution;
+    size_t touched;
+    size_t processed;
+    uint32_t lower_bound;
+    [[no_unique_address]] search_counters stats{};
+};
+
+// find_solution_manhattan_wadditional that gives up on the limits, the stop token and the clock are only read every check_every expansions
+template <uint32_t psize, typename Heuristic, typename Queue>
+solve_result<psize> find_solution_limited(permut_t<psize> initial, Heuristic additional, const solve_limits& limits, Queue& queue) {
+    using clock = std::chrono::steady_clock;
+    constexpr size_t check_every = 1024;
+    if (!permut_solvable<psize>(initial)) {
+        return {solve_status::unsolvable, std::nullopt, 0, 0, 0};
+    }
+    const clock::time_point start = clock::now();
+    const clock::time_point deadline =
+        std::min(limits.deadline, limits.time_budget >= clock::time_point::max() - start ? clock::time_point::max() : start + limits.time_budget);
+    solve_status status = solve_status::unsolvable;
+    size_t processed = 0;
+    // the lowest open f never passes the optimum
+    uint32_t lower_bound = 0;
+    auto sol = find_solution_manhattan_wadditional<psize>(initial, additional, queue, [&](const auto& top, size_t expanded) {
+        processed = expanded;
+        lower_bound = std::max<uint32_t>(lower_bound, top.dist_to + top.dist_h);
+        if (expanded >= limits.node_budget) {
+            status = solve_status::node_budget;
+            return true;
+        }
+        if (expanded % check_every == 0) {
+            if (limits.stop.stop_requested()) {
+                status = solve_status::cancelled;
+                return true;
+            }
+            if (clock::now() >= deadline) {
+                status = solve_status::deadline;
+                return true;
+            }
+        }
+        return false;
+    });
+    if (sol) {
+        const size_t touched = sol->touched;
+        const size_t sol_processed = sol->processed;
+        const uint32_t length = sol->steps.size() - 1;
+        return {solve_status::solved, std::move(sol), touched, sol_processed, length, queue.stats().counters()};
+    }
+    return {status, std::nullopt, queue.map_size(), processed, lower_bound, queue.stats().counters()};
+}
+
+// solves on a shared pool, one queue per worker is reused by every solve that runs there; waits for its solves when destroyed
+template <uint32_t psize, typename Heuristic = linear_conflict_heuristic<psize>, typename Queue = puzzle_bucket_queue_t<psize>>
+class async_solver {
+    thread_pool& pool;
+    const Heuristic additional;
+    std::vector<Queue> queues;
+    std::mutex mutex;
+    std::condition_variable idle;
+    size_t running = 0;
+
+    template <typename Done>
+    void start(permut_t<psize> initial, solve_limits limits, Done done) {
+        {
+            std::lock_guard lock(mutex);
+            ++running;
+        }
+        pool.submit([this, initial, limits = std::move(limits), done = std::move(done)]() mutable {
+            // notifies under the lock, the solver may be gone right after
+            struct finish {
+                async_solver& solver;
+                ~finish() {
+                    std::lock_guard lock(solver.mutex);
+                    --solver.running;
+                    solver.idle.notify_all();
+                }
+            } on_exit{*this};
+            done(find_solution_limited<psize>(initial, additional, limits, queues[thread_pool::worker_index()]));
+        });
+    }
+
+public:
+    explicit async_solver(thread_pool& pool, Heuristic additional = {}) : pool(pool), additional(std::move(additional)), queues(pool.size()) {}
+    async_solver(const async_solver&) = delete;
+    async_solver& operator=(const async_solver&) = delete;
+    ~async_solver() {
+        wait();
+    }
+
+    std::future<solve_result<psize>> submit(permut_t<psize> initial, solve_limits limits = {}) {
+        auto promise = std::make_shared<std::promise<solve_result<psize>>>();
+        auto result = promise->get_future();
+        start(initial, std::move(limits), [promise](solve_result<psize> r) { promise->set_value(std::move(r)); });
+        return result;
+    }
+    // on_done runs on a pool thread
+    void submit(permut_t<psize> initial, solve_limits limits, std::function<void(solve_result<psize>)> on_done) {
+        start(initial, std::move(limits), std::move(on_done));
+    }
+
+    // blocks until every submitted solve has finished
+    void wait() {
+        std::unique_lock lock(mutex);
+        idle.wait(lock, [this] { return running == 0; });
+    }
+};
+
+}  // namespace puzzle
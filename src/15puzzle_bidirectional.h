@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_hash_map.h"
+#include "15puzzle_rank.h"
+#include "15puzzle_solver.h"
+
+namespace puzzle {
+
+// manhattan distance plus linear conflict towards any board, the backward search aims at the initial board
+template <uint32_t psize>
+class target_heuristic {
+    static constexpr uint32_t n_fields = psize * psize;
+
+    // [tile][field], the empty field counts 0
+    std::array<std::array<dist_type, n_fields>, n_fields> manhattan{};
+    linear_conflict_tables<psize> lc;
+
+public:
+    explicit target_heuristic(permut_t<psize> target) : lc(permut_fields<psize>(target)) {
+        const auto goal_field = permut_fields<psize>(target);
+        auto diff = [](uint32_t a, uint32_t b) -> dist_type {
+            return a > b ? a - b : b - a;
+        };
+        for (uint32_t tile = 0; tile < n_fields - 1; ++tile) {
+            for (uint32_t pozz = 0; pozz < n_fields; ++pozz) {
+                manhattan[tile][pozz] = diff(pozz / psize, goal_field[tile] / psize) + diff(pozz % psize, goal_field[tile] % psize);
+            }
+        }
+    }
+
+    dist_type manhattan_dist(permut_t<psize> a) const noexcept {
+        constexpr int offset = std::bit_width(n_fields - 1);
+        constexpr permut_t<psize> mask = ~(~0U << offset);
+        dist_type dist = 0;
+        for (uint32_t pozz = n_fields - 1; pozz != static_cast<uint32_t>(-1); --pozz) {
+            dist += manhattan[static_cast<uint32_t>(a & mask)][pozz];
+            a >>= offset;
+        }
+        return dist;
+    }
+    // to has the tile from field to_blank moved into from_blank
+    dist_type manhattan_update(permut_t<psize> to, uint32_t from_blank, uint32_t to_blank, dist_type from_value) const noexcept {
+        constexpr int offset = std::bit_width(n_fields - 1);
+        constexpr permut_t<psize> mask = ~(~0U << offset);
+        const uint32_t tile = (to >> ((n_fields - 1 - from_blank) * offset)) & mask;
+        return from_value - manhattan[tile][to_blank] + manhattan[tile][from_blank];
+    }
+    dist_type linear_conflict(permut_t<psize> a) const noexcept {
+        return puzzle::linear_conflict<psize>(lc, a);
+    }
+    dist_type linear_conflict_update(permut_t<psize> from, permut_t<psize> to, dist_type from_value) const noexcept {
+        return puzzle::linear_conflict_update<psize>(lc, from, to, from_value);
+    }
+    dist_type operator()(permut_t<psize> a) const noexcept {
+        return manhattan_dist(a) + linear_conflict(a);
+    }
+};
+
+// DIBBS: A* from both ends ordered by 2g + h - h_back, where h_back is the other direction's heuristic, i.e. the estimate back to the node's
+// own root. A path through an open node of each direction costs at least half the sum of their priorities when the heuristics are
+// consistent, which bounds the rest far tighter than MM's max(f, 2g + 1) does with a heuristic as strong as linear conflict
+template <uint32_t psize>
+class bidirectional_search {
+    using permut = permut_t<psize>;
+
+    static constexpr uint32_t no_solution = std::numeric_limits<uint32_t>::max();
+
+    struct node {
+        permut_t<psize> permut;
+        dist_type dist_to;
+        dist_type dist_h;
+        // heuristic back to the root of the direction, never above dist_to
+        dist_type dist_back;
+        move_dir parent_move;
+        uint8_t blank;
+        bool closed;
+    };
+
+    // live open nodes per value, min is kept up to date for the stopping rule
+    struct open_count {
+        std::vector<size_t> count;
+        uint32_t min = no_solution;
+
+        void add(uint32_t value) {
+            if (value >= count.size()) {
+                count.resize(value + 1);
+            }
+            ++count[value];
+            min = std::min(min, value);
+        }
+        void remove(uint32_t value) noexcept {
+            --count[value];
+            while (min < count.size() && count[min] == 0) {
+                ++min;
+            }
+            if (min == count.size()) {
+                min = no_solution;
+            }
+        }
+    };
+
+    struct bucket_entry {
+        node_index index;
+        dist_type dist_to;
+    };
+
+    // one direction, open nodes sit in buckets by priority and then priority - g, so larger g goes first
+    struct frontier {
+        target_heuristic<psize> heuristic;
+        permut_hash_map<node> map;
+        std::vector<std::vector<std::vector<bucket_entry>>> buckets;
+        open_count pr_count;
+        open_count f_count;
+        size_t open = 0;
+        size_t processed = 0;
+
+        explicit frontier(permut target) : heuristic(target) {}
+
+        static uint32_t priority(const node& n) noexcept {
+            return 2 * n.dist_to + n.dist_h - n.dist_back;
+        }
+        void insert(node_index i) {
+            node& n = map[i];
+            n.closed = false;
+            const uint32_t pr = priority(n);
+            const uint32_t rest = pr - n.dist_to;
+            if (pr >= buckets.size()) {
+                buckets.resize(pr + 1);
+            }
+            if (rest >= buckets[pr].size()) {
+                buckets[pr].resize(rest + 1);
+            }
+            buckets[pr][rest].push_back({i, n.dist_to});
+            pr_count.add(pr);
+            f_count.add(n.dist_to + n.dist_h);
+            ++open;
+        }
+        void erase_counts(const node& n) noexcept {
+            pr_count.remove(priority(n));
+            f_count.remove(n.dist_to + n.dist_h);
+            --open;
+        }
+        void push(permut p, uint8_t blank, move_dir parent_move, dist_type dist_to, dist_type dist_h, dist_type dist_back) {
+            insert(map.insert(node{p, dist_to, dist_h, dist_back, parent_move, blank, false}).first);
+        }
+        void decrease_key(node_index i, move_dir parent_move, dist_type dist_to) {
+            node& n = map[i];
+            if (!n.closed) {
+                erase_counts(n);
+            }
+            n.dist_to = dist_to;
+            n.parent_move = parent_move;
+            insert(i);
+        }
+        // the live open node with the lowest priority and the highest g, closed on return
+        node_index pop() noexcept {
+            const uint32_t pr = pr_count.min;
+            auto& rests = buckets[pr];
+            for (uint32_t rest = 0;; ++rest) {
+                auto& bucket = rests[rest];
+                while (!bucket.empty()) {
+                    const bucket_entry b_entry = bucket.back();
+                    bucket.pop_back();
+                    node& n = map[b_entry.index];
+                    if (n.dist_to == b_entry.dist_to && !n.closed) {
+                        erase_counts(n);
+                        n.closed = true;
+                        return b_entry.index;
+                    }
+                }
+            }
+        }
+    };
+
+    frontier forward;
+    frontier backward;
+    uint32_t best = no_solution;
+    permut meeting{};
+    uint32_t parity = 0;
+
+    void expand(frontier& self, const frontier& other) {
+        const node current = self.map[self.pop()];
+        ++self.processed;
+        const dist_type mdist = self.heuristic.manhattan_dist(current.permut);
+        const dist_type lc = current.dist_h - mdist;
+        const dist_type back_mdist = other.heuristic.manhattan_dist(current.permut);
+        const dist_type back_lc = current.dist_back - back_mdist;
+        permut_moves_itr<psize> neighbours(current.permut, current.blank, current.parent_move);
+        for (auto& n : neighbours) {
+            const dist_type dist_new = current.dist_to + 1;
+            const node_index n_index = self.map.find(n.permut);
+            if (n_index == self.map.end()) {
+                const dist_type dist_h = self.heuristic.manhattan_update(n.permut, current.blank, n.blank, mdist) +
+                                         self.heuristic.linear_conflict_update(current.permut, n.permut, lc);
+                const dist_type dist_back = other.heuristic.manhattan_update(n.permut, current.blank, n.blank, back_mdist) +
+                                            other.heuristic.linear_conflict_update(current.permut, n.permut, back_lc);
+                self.push(n.permut, n.blank, n.dir, dist_new, dist_h, dist_back);
+            } else if (dist_new < self.map[n_index].dist_to) {
+                self.decrease_key(n_index, n.dir, dist_new);
+            } else {
+                continue;
+            }
+            const node_index o_index = other.map.find(n.permut);
+            if (o_index != other.map.end() && dist_new + other.map[o_index].dist_to < best) {
+                best = dist_new + other.map[o_index].dist_to;
+                meeting = n.permut;
+            }
+        }
+    }
+    // parent chain from p back to the root of one direction, p first
+    static std::vector<permut> chain(const frontier& f, permut p) {
+        std::vector<permut> steps = {p};
+        for (move_dir dir = f.map[f.map.find(p)].parent_move; dir != move_none; dir = f.map[f.map.find(p)].parent_move) {
+            p = permut_undo_move<psize>(p, dir);
+            steps.push_back(p);
+        }
+        return steps;
+    }
+
+public:
+    bidirectional_search(permut initial, permut goal) : forward(goal), backward(initial) {
+        forward.push(initial, permut_blank<psize>(initial), move_none, 0, forward.heuristic(initial), 0);
+        backward.push(goal, permut_blank<psize>(goal), move_none, 0, backward.heuristic(goal), 0);
+        parity = forward.heuristic(initial) & 1;
+        if (initial == goal) {
+            best = 0;
+            meeting = initial;
+        }
+    }
+
+    std::optional<solution_t<psize>> solve() {
+        while (forward.open != 0 && backward.open != 0) {
+            // every path not found yet costs at least this much, and every solution has the parity of the initial board's heuristic
+            uint32_t lower_bound = std::max({(forward.pr_count.min + backward.pr_count.min + 1) / 2, forward.f_count.min, backward.f_count.min});
+            lower_bound += (lower_bound ^ parity) & 1;
+            if (best <= lower_bound) {
+                break;
+            }
+            // on a tie the smaller frontier goes first
+            if (forward.pr_count.min < backward.pr_count.min || (forward.pr_count.min == backward.pr_count.min && forward.open <= backward.open)) {
+                expand(forward, backward);
+            } else {
+                expand(backward, forward);
+            }
+        }
+        if (best == no_solution) {
+            return std::nullopt;
+        }
+        // steps run from the goal to the initial board like the other solvers
+        std::vector<permut> steps = chain(backward, meeting);
+        std::reverse(steps.begin(), steps.end());
+        steps.pop_back();
+        const std::vector<permut> to_initial = chain(forward, meeting);
+        steps.insert(steps.end(), to_initial.begin(), to_initial.end());
+        return solution_t<psize>{forward.map.size() + backward.map.size(), forward.processed + backward.processed, std::move(steps)};
+    }
+};
+
+template <uint32_t psize>
+std::optional<solution_t<psize>> find_solution_bidirectional(permut_t<psize> initial) {
+    if (!permut_solvable<psize>(initial)) {
+        return std::nullopt;
+    }
+    bidirectional_search<psize> search(initial, permut_goal<psize>);
+    return search.solve();
+}
+
+}  // namespace puzzle
@@ -0,0 +1,438 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_hash_map.h"
+#include "15puzzle_io.h"
+#include "15puzzle_rank.h"
+#include "15puzzle_solver.h"
+
+namespace puzzle {
+
+// the board mirrored on the main diagonal with the tiles renumbered the same way, the goal maps onto itself
+template <uint32_t psize>
+permut_t<psize> permut_transpose(permut_t<psize> permut) {
+    constexpr auto transpose = [](uint32_t field) {
+        return field % psize * psize + field / psize;
+    };
+    const auto tiles = permut_to_array<psize>(permut);
+    std::array<uint32_t, psize * psize> mirrored{};
+    for (uint32_t pozz = 0; pozz < psize * psize; ++pozz) {
+        mirrored[transpose(pozz)] = transpose(tiles[pozz]);
+    }
+    return permut_create<psize>(mirrored);
+}
+
+// the inverse permutation, field t holds the field of tile t; it is as far from the goal as the board only with the empty field in its
+// goal place, where the moves that solve it are the board's moves reversed and turned around
+template <uint32_t psize>
+permut_t<psize> permut_dual(permut_t<psize> permut) {
+    const auto field_of = permut_fields<psize>(permut);
+    std::array<uint32_t, psize * psize> inverse{};
+    std::copy(field_of.begin(), field_of.end(), inverse.begin());
+    return permut_create<psize>(inverse);
+}
+
+// solved boards keyed on the least of the board's symmetric images, the most recent in memory and all of them in an append-only file;
+// the file and its hash index (path.index) are memory-mapped, so looking up the stored boards costs page cache, not heap; not synchronised
+template <uint32_t psize>
+class solution_cache {
+    using permut = permut_t<psize>;
+
+    static constexpr uint32_t file_version = 1;
+    static constexpr char file_magic[8] = {'1', '5', 'P', 'Z', 'C', 'A', 'C', 'H'};
+
+    struct file_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t board_size;
+    };
+
+    // a record is the key, the move count and the moves as moves_pack packs them
+    static constexpr size_t record_head = sizeof(permut) + sizeof(uint16_t);
+
+    struct permut_hasher {
+        size_t operator()(permut key) const noexcept {
+            return permut_fold(key) * 0x9E3779B97F4A7C15ULL;
+        }
+    };
+
+    struct canonical {
+        permut key;
+        bool transposed;
+        bool dual;
+    };
+
+    struct lru_entry {
+        permut key;
+        uint16_t n_moves;
+        std::vector<uint8_t> packed;
+    };
+
+    // the index next to the file: open addressing (linear probing) over record offsets, 0 is an empty slot; data_size is the file
+    // size it covers, an index that does not cover the file is built again from the records
+    struct index_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t board_size;
+        uint64_t capacity;
+        uint64_t count;
+        uint64_t data_size;
+    };
+    static constexpr char index_magic[8] = {'1', '5', 'P', 'Z', 'C', 'I', 'D', 'X'};
+    static constexpr uint64_t min_index_capacity = 1 << 12;
+
+    size_t capacity;
+    std::list<lru_entry> lru;
+    std::unordered_map<permut, typename std::list<lru_entry>::iterator, permut_hasher> in_memory;
+    int fd = -1;
+    // the file is mapped with room to grow, only the bytes below file_size are read
+    const uint8_t* mapped = nullptr;
+    size_t mapped_size = 0;
+    size_t file_size = 0;
+    int index_fd = -1;
+    index_header* index = nullptr;
+    uint64_t* slots = nullptr;
+    size_t hit_count = 0;
+    size_t miss_count = 0;
+
+    static canonical canonicalize(permut board) {
+        canonical best{board, false, false};
+        auto consider = [&](permut image, bool transposed, bool dual) {
+            if (image < best.key) {
+                best = {image, transposed, dual};
+            }
+        };
+        const permut transposed = permut_transpose<psize>(board);
+        consider(transposed, true, false);
+        if (permut_blank<psize>(board) == psize * psize - 1) {
+            const permut dual = permut_dual<psize>(board);
+            consider(dual, false, true);
+            consider(permut_transpose<psize>(dual), true, true);
+        }
+        return best;
+    }
+    // both symmetries are their own inverse and commute, so the same mapping goes either way
+    static void map_moves(std::vector<move_dir>& moves, bool transposed, bool dual) {
+        if (transposed) {
+            // down and right, left and up trade places
+            for (move_dir& dir : moves) {
+                dir = static_cast<move_dir>(3 - dir);
+            }
+        }
+        if (dual) {
+            std::reverse(moves.begin(), moves.end());
+            for (move_dir& dir : moves) {
+                dir = move_opposite(dir);
+            }
+        }
+    }
+
+    void remap() {
+        if (mapped != nullptr) {
+            munmap(const_cast<uint8_t*>(mapped), mapped_size);
+            mapped = nullptr;
+        }
+        mapped_size = std::bit_ceil(std::max<size_t>(file_size, 1 << 20));
+        void* area = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (area == MAP_FAILED) {
+            throw std::runtime_error("solution_cache: cannot map the file");
+        }
+        mapped = static_cast<const uint8_t*>(area);
+    }
+    permut key_at(uint64_t offset) {
+        if (file_size > mapped_size) {
+            remap();
+        }
+        permut key;
+        std::memcpy(&key, mapped + offset, sizeof(key));
+        return key;
+    }
+    // offset of every complete record in order, returns the end of the last one
+    template <typename F>
+    size_t for_each_record(F&& f) {
+        if (file_size > mapped_size) {
+            remap();
+        }
+        size_t offset = sizeof(file_header);
+        while (offset + record_head <= file_size) {
+            uint16_t n_moves;
+            std::memcpy(&n_moves, mapped + offset + sizeof(permut), sizeof(n_moves));
+            const size_t length = record_head + (n_moves + 3) / 4;
+            if (offset + length > file_size) {
+                break;
+            }
+            f(offset);
+            offset += length;
+        }
+        return offset;
+    }
+
+    // the slot holding key or the empty slot where it goes
+    uint64_t& index_slot(permut key) {
+        const uint64_t mask = index->capacity - 1;
+        for (uint64_t i = (permut_fold(key) * 0x9E3779B97F4A7C15ULL) >> (64 - std::countr_zero(index->capacity));; i = (i + 1) & mask) {
+            if (slots[i] == 0 || key_at(slots[i]) == key) {
+                return slots[i];
+            }
+        }
+    }
+    // the first record of a key wins, like a lookup before every insert would have it
+    void index_add(uint64_t offset) {
+        uint64_t& slot = index_slot(key_at(offset));
+        if (slot == 0) {
+            slot = offset;
+            ++index->count;
+        }
+    }
+    void unmap_index() noexcept {
+        if (index != nullptr) {
+            munmap(index, sizeof(index_header) + index->capacity * sizeof(uint64_t));
+            index = nullptr;
+            slots = nullptr;
+        }
+    }
+    void map_index(uint64_t index_capacity) {
+        void* area = mmap(nullptr, sizeof(index_header) + index_capacity * sizeof(uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED, index_fd, 0);
+        if (area == MAP_FAILED) {
+            throw std::runtime_error("solution_cache: cannot map the index");
+        }
+        index = static_cast<index_header*>(area);
+        slots = reinterpret_cast<uint64_t*>(index + 1);
+    }
+    // a zeroed index of index_capacity slots filled from the records in the file
+    void rebuild_index(uint64_t index_capacity) {
+        unmap_index();
+        const size_t size = sizeof(index_header) + index_capacity * sizeof(uint64_t);
+        if (ftruncate(index_fd, 0) != 0 || ftruncate(index_fd, size) != 0) {
+            throw std::runtime_error("solution_cache: cannot resize the index");
+        }
+        map_index(index_capacity);
+        std::memcpy(index->magic, index_magic, sizeof(index_magic));
+        index->version = file_version;
+        index->board_size = psize;
+        index->capacity = index_capacity;
+        index->count = 0;
+        for_each_record([this](size_t offset) {
+            index_add(offset);
+        });
+        index->data_size = file_size;
+    }
+    void grow_index_for(uint64_t count) {
+        uint64_t index_capacity = min_index_capacity;
+        while (count * 4 > index_capacity * 3) {
+            index_capacity *= 2;
+        }
+        rebuild_index(index_capacity);
+    }
+
+    // checks the header, drops a record cut short by a crash and opens the index, building it again unless it covers the whole file
+    void load(const std::string& path) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            throw std::runtime_error("solution_cache: cannot stat " + path);
+        }
+        file_size = st.st_size;
+        if (file_size == 0) {
+            file_header header{{}, file_version, psize};
+            std::memcpy(header.magic, file_magic, sizeof(file_magic));
+            append(&header, sizeof(header));
+        }
+        if (file_size < sizeof(file_header)) {
+            throw std::runtime_error("solution_cache: " + path + " has a wrong header");
+        }
+        remap();
+        file_header header;
+        std::memcpy(&header, mapped, sizeof(header));
+        if (std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0 || header.version != file_version || header.board_size != psize) {
+            throw std::runtime_error("solution_cache: " + path + " has a wrong header");
+        }
+        uint64_t n_records = 0;
+        const size_t end = for_each_record([&n_records](size_t) {
+            ++n_records;
+        });
+        if (end != file_size) {
+            if (ftruncate(fd, end) != 0) {
+                throw std::runtime_error("solution_cache: cannot truncate " + path);
+            }
+            file_size = end;
+        }
+        const std::string index_path = path + ".index";
+        index_fd = open(index_path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (index_fd < 0) {
+            throw std::runtime_error("solution_cache: cannot open " + index_path);
+        }
+        if (fstat(index_fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(index_header)) {
+            index_header stored;
+            if (pread(index_fd, &stored, sizeof(stored), 0) == sizeof(stored) && std::memcmp(stored.magic, index_magic, sizeof(index_magic)) == 0 &&
+                stored.version == file_version && stored.board_size == psize && stored.data_size == file_size &&
+                stored.capacity >= min_index_capacity && std::has_single_bit(stored.capacity) &&
+                static_cast<size_t>(st.st_size) == sizeof(index_header) + stored.capacity * sizeof(uint64_t)) {
+                map_index(stored.capacity);
+                return;
+            }
+        }
+        grow_index_for(n_records);
+    }
+    void append(const void* data, size_t length) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        while (length > 0) {
+            const ssize_t written = write(fd, bytes, length);
+            if (written < 0) {
+                throw std::runtime_error("solution_cache: cannot write the file");
+            }
+            bytes += written;
+            length -= written;
+            file_size += written;
+        }
+    }
+
+    void remember(permut key, uint16_t n_moves, std::vector<uint8_t> packed) {
+        lru.push_front({key, n_moves, std::move(packed)});
+        in_memory[key] = lru.begin();
+        if (lru.size() > capacity) {
+            in_memory.erase(lru.back().key);
+            lru.pop_back();
+        }
+    }
+
+public:
+    // an empty path keeps the cache in memory only
+    explicit solution_cache(size_t capacity, const std::string& path = "") : capacity(std::max<size_t>(capacity, 1)) {
+        if (path.empty()) {
+            return;
+        }
+        fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("solution_cache: cannot open " + path);
+        }
+        try {
+            load(path);
+        } catch (...) {
+            close();
+            throw;
+        }
+    }
+    solution_cache(const solution_cache&) = delete;
+    solution_cache& operator=(const solution_cache&) = delete;
+    ~solution_cache() {
+        close();
+    }
+
+    void close() noexcept {
+        unmap_index();
+        if (index_fd >= 0) {
+            ::close(index_fd);
+            index_fd = -1;
+        }
+        if (mapped != nullptr) {
+            munmap(const_cast<uint8_t*>(mapped), mapped_size);
+            mapped = nullptr;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    // moves from board to the goal
+    std::optional<std::vector<move_dir>> find(permut board) {
+        const canonical c = canonicalize(board);
+        std::vector<move_dir> moves;
+        if (const auto found = in_memory.find(c.key); found != in_memory.end()) {
+            lru.splice(lru.begin(), lru, found->second);
+            moves = moves_unpack(found->second->packed.data(), found->second->n_moves);
+        } else if (const uint64_t offset = fd >= 0 ? index_slot(c.key) : 0; offset != 0) {
+            uint16_t n_moves;
+            std::memcpy(&n_moves, mapped + offset + sizeof(permut), sizeof(n_moves));
+            const uint8_t* packed = mapped + offset + record_head;
+            moves = moves_unpack(packed, n_moves);
+            remember(c.key, n_moves, std::vector<uint8_t>(packed, packed + (n_moves + 3) / 4));
+        } else {
+            ++miss_count;
+            return std::nullopt;
+        }
+        ++hit_count;
+        map_moves(moves, c.transposed, c.dual);
+        return moves;
+    }
+
+    // moves from board to the goal, a board that is known already is left alone
+    void insert(permut board, std::vector<move_dir> moves) {
+        if (moves.size() > std::numeric_limits<uint16_t>::max()) {
+            throw std::invalid_argument("solution_cache: too many moves");
+        }
+        const canonical c = canonicalize(board);
+        if (in_memory.contains(c.key) || (fd >= 0 && index_slot(c.key) != 0)) {
+            return;
+        }
+        map_moves(moves, c.transposed, c.dual);
+        const uint16_t n_moves = moves.size();
+        std::vector<uint8_t> packed = moves_pack(moves);
+        if (fd >= 0) {
+            std::vector<uint8_t> record(record_head + packed.size());
+            std::memcpy(record.data(), &c.key, sizeof(c.key));
+            std::memcpy(record.data() + sizeof(c.key), &n_moves, sizeof(n_moves));
+            std::copy(packed.begin(), packed.end(), record.begin() + record_head);
+            uint64_t& slot = index_slot(c.key);
+            const size_t offset = file_size;
+            append(record.data(), record.size());
+            slot = offset;
+            ++index->count;
+            index->data_size = file_size;
+            if (index->count * 4 > index->capacity * 3) {
+                grow_index_for(index->count);
+            }
+        }
+        remember(c.key, n_moves, std::move(packed));
+    }
+
+    // distinct boards up to symmetry, in the file or in memory only
+    size_t size() const noexcept {
+        return fd >= 0 ? index->count : in_memory.size();
+    }
+    size_t hits() const noexcept {
+        return hit_count;
+    }
+    size_t misses() const noexcept {
+        return miss_count;
+    }
+};
+
+// a cache hit replays the stored moves and reports nothing touched or processed, a miss is solved and stored
+template <uint32_t psize, typename Heuristic, typename Queue>
+std::optional<solution_t<psize>> find_solution_cached(permut_t<psize> initial, Heuristic additional, solution_cache<psize>& cache, Queue& queue) {
+    if (const auto moves = cache.find(initial)) {
+        return solution_t<psize>{0, 0, moves_steps<psize>(initial, *moves)};
+    }
+    auto sol = find_solution_manhattan_wadditional<psize>(initial, additional, queue);
+    if (sol) {
+        cache.insert(initial, solution_moves<psize>(sol->steps));
+    }
+    return sol;
+}
+
+template <uint32_t psize, typename Heuristic, typename Queue = puzzle_queue_t<psize>>
+std::optional<solution_t<psize>> find_solution_cached(permut_t<psize> initial, Heuristic additional, solution_cache<psize>& cache) {
+    Queue queue;
+    return find_solution_cached<psize>(initial, additional, cache, queue);
+}
+
+}  // namespace puzzle
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_rank.h"
+#include "15puzzle_solver.h"
+
+namespace puzzle {
+
+// distance to the goal of every board, 4 bits per board indexed by permut_rank, only practical for the 8-puzzle
+template <uint32_t psize>
+class distance_table {
+    static_assert(psize == 3, "the table has (psize * psize)! entries");
+    static constexpr uint64_t n_states = permut_rank_size<psize>();
+    // distances are kept modulo 15, a neighbour one move closer is all the descent needs to know
+    static constexpr uint8_t modulus = 15;
+    static constexpr uint8_t unreachable = 0xf;
+    static constexpr uint32_t file_version = 1;
+    static constexpr char file_magic[8] = {'1', '5', 'P', 'Z', 'D', 'I', 'S', 'T'};
+
+    struct file_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t board_size;
+    };
+
+    std::vector<uint8_t> nibbles = std::vector<uint8_t>(n_states / 2, 0xff);
+
+    uint8_t get(permut_t<psize> permut) const noexcept {
+        const uint64_t rank = permut_rank<psize>(permut);
+        return (nibbles[rank / 2] >> (rank % 2 * 4)) & 0xf;
+    }
+    void set(uint64_t rank, uint8_t value) noexcept {
+        uint8_t& byte = nibbles[rank / 2];
+        byte = (byte & ~(0xf << (rank % 2 * 4))) | (value << (rank % 2 * 4));
+    }
+
+public:
+    // breadth first search from the goal over the reachable half, a few milliseconds
+    static distance_table generate() {
+        struct frontier_entry {
+            permut_t<psize> permut;
+            uint8_t blank;
+        };
+        distance_table table;
+        constexpr permut_t<psize> goal = permut_goal<psize>;
+        std::vector<frontier_entry> current = {{goal, psize * psize - 1}};
+        std::vector<frontier_entry> next;
+        table.set(permut_rank<psize>(goal), 0);
+        for (uint32_t dist = 1; !current.empty(); ++dist) {
+            next.clear();
+            for (const frontier_entry& entry : current) {
+                for (const auto& n : permut_moves_itr<psize>(entry.permut, entry.blank)) {
+                    const uint64_t rank = permut_rank<psize>(n.permut);
+                    if (((table.nibbles[rank / 2] >> (rank % 2 * 4)) & 0xf) == unreachable) {
+                        table.set(rank, dist % modulus);
+                        next.push_back({n.permut, n.blank});
+                    }
+                }
+            }
+            std::swap(current, next);
+        }
+        return table;
+    }
+
+    static distance_table load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("distance_table: cannot open " + path);
+        }
+        file_header header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0 || header.version != file_version || header.board_size != psize) {
+            throw std::runtime_error("distance_table: " + path + " has a wrong header");
+        }
+        distance_table table;
+        file.read(reinterpret_cast<char*>(table.nibbles.data()), table.nibbles.size());
+        if (!file) {
+            throw std::runtime_error("distance_table: " + path + " is truncated");
+        }
+        return table;
+    }
+
+    void save(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("distance_table: cannot open " + path);
+        }
+        file_header header{{}, file_version, psize};
+        std::memcpy(header.magic, file_magic, sizeof(file_magic));
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(nibbles.data()), nibbles.size());
+        if (!file) {
+            throw std::runtime_error("distance_table: cannot write " + path);
+        }
+    }
+
+    bool solvable(permut_t<psize> permut) const noexcept {
+        return get(permut) != unreachable;
+    }
+
+    // greedy descent to the goal, every step goes to the neighbour one move closer, touched counts the table reads
+    std::optional<solution_t<psize>> solve(permut_t<psize> initial) const {
+        uint8_t dist = get(initial);
+        if (dist == unreachable) {
+            return std::nullopt;
+        }
+        constexpr permut_t<psize> goal = permut_goal<psize>;
+        std::vector<permut_t<psize>> path = {initial};
+        size_t touched = 1;
+        permut_t<psize> current = initial;
+        uint8_t blank = permut_blank<psize>(initial);
+        move_dir previous = move_none;
+        while (current != goal) {
+            const uint8_t closer = (dist + modulus - 1) % modulus;
+            for (const auto& n : permut_moves_itr<psize>(current, blank, previous)) {
+                ++touched;
+                if (get(n.permut) == closer) {
+                    current = n.permut;
+                    blank = n.blank;
+                    previous = n.dir;
+                    break;
+                }
+            }
+            dist = closer;
+            path.push_back(current);
+        }
+        const size_t processed = path.size() - 1;
+        return solution_t<psize>{touched, processed, {path.rbegin(), path.rend()}};
+    }
+};
+
+}  // namespace puzzle
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_bidirectional.h"
+#include "15puzzle_hash_map.h"
+#include "15puzzle_solver.h"
+
+namespace puzzle {
+
+// breadth first heuristic search: layers by g pruned at an f bound raised like IDA*, only the previous, current and next layer are kept;
+// a move always changes the parity of the empty field's distance to its goal field, so a neighbour is in the previous or the next layer
+template <uint32_t psize>
+class frontier_search {
+    using permut = permut_t<psize>;
+
+    static constexpr uint32_t no_bound = std::numeric_limits<uint32_t>::max();
+
+    struct layer_node {
+        permut_t<psize> permut;
+        // index of the ancestor in the relay layer, the middle of the path
+        uint32_t relay;
+        dist_type mdist;
+        dist_type lc;
+        uint8_t blank;
+    };
+    using layer = permut_hash_map<layer_node>;
+
+    struct layer_result {
+        bool found;
+        uint32_t dist;
+        permut relay;
+        uint32_t relay_dist;
+        uint32_t next_bound;
+    };
+
+    layer previous;
+    layer current;
+    layer next;
+    std::vector<permut> relays;
+    size_t processed = 0;
+    size_t peak = 0;
+
+    // every board within bound of from on the way to to, layer by layer
+    layer_result search(permut from, permut to, const target_heuristic<psize>& heuristic, uint32_t bound, uint32_t relay_dist) {
+        layer_result result{false, 0, from, 0, no_bound};
+        if (from == to) {
+            result.found = true;
+            return result;
+        }
+        previous.clear();
+        current.clear();
+        relays.clear();
+        const dist_type mdist = heuristic.manhattan_dist(from);
+        current.insert(layer_node{from, 0, mdist, heuristic.linear_conflict(from), permut_blank<psize>(from)});
+        for (uint32_t dist = 0; current.size() != 0; ++dist) {
+            if (dist == relay_dist) {
+                relays.clear();
+                for (node_index i = 0; i < current.size(); ++i) {
+                    current[i].relay = relays.size();
+                    relays.push_back(current[i].permut);
+                }
+            }
+            next.clear();
+            for (node_index i = 0; i < current.size(); ++i) {
+                const layer_node node = current[i];
+                ++processed;
+                for (const auto& n : permut_moves_itr<psize>(node.permut, node.blank)) {
+                    const dist_type n_mdist = heuristic.manhattan_update(n.permut, node.blank, n.blank, node.mdist);
+                    const dist_type n_lc = heuristic.linear_conflict_update(node.permut, n.permut, node.lc);
+                    const uint32_t dist_f = dist + 1 + n_mdist + n_lc;
+                    if (dist_f > bound) {
+                        result.next_bound = std::min(result.next_bound, dist_f);
+                        continue;
+                    }
+                    if (previous.find(n.permut) != previous.end()) {
+                        continue;
+                    }
+                    if (n.permut == to) {
+                        result.found = true;
+                        result.dist = dist + 1;
+                        result.relay = dist + 1 <= relay_dist ? n.permut : relays[node.relay];
+                        result.relay_dist = std::min(dist + 1, relay_dist);
+                        return result;
+                    }
+                    next.insert(layer_node{n.permut, node.relay, n_mdist, n_lc, n.blank});
+                }
+            }
+            peak = std::max(peak, previous.size() + current.size() + next.size() + relays.size());
+            std::swap(previous, current);
+            std::swap(current, next);
+        }
+        return result;
+    }
+
+    // appends the boards after from up to to, dist moves apart
+    void reconstruct(permut from, permut to, uint32_t dist, std::vector<permut>& path) {
+        if (dist == 0) {
+            return;
+        }
+        if (dist == 1) {
+            path.push_back(to);
+            return;
+        }
+        const target_heuristic<psize> heuristic(to);
+        const layer_result found = search(from, to, heuristic, dist, dist / 2);
+        reconstruct(from, found.relay, found.relay_dist, path);
+        reconstruct(found.relay, to, found.dist - found.relay_dist, path);
+    }
+
+public:
+    // touched is the most boards held at once, relay layer included
+    std::optional<solution_t<psize>> solve(permut initial) {
+        constexpr permut goal = permut_goal<psize>;
+        const target_heuristic<psize> heuristic(goal);
+        processed = 0;
+        peak = 1;
+        uint32_t bound = heuristic(initial);
+        while (bound != no_bound) {
+            const layer_result found = search(initial, goal, heuristic, bound, bound / 2);
+            if (found.found) {
+                std::vector<permut> path = {initial};
+                reconstruct(initial, found.relay, found.relay_dist, path);
+                reconstruct(found.relay, goal, found.dist - found.relay_dist, path);
+                return solution_t<psize>{peak, processed, {path.rbegin(), path.rend()}};
+            }
+            bound = found.next_bound;
+        }
+        return std::nullopt;
+    }
+};
+
+// BFHS with divide and conquer solution reconstruction, memory grows with the widest layer rather than with the explored space
+template <uint32_t psize>
+std::optional<solution_t<psize>> find_solution_frontier(permut_t<psize> initial) {
+    if (!permut_solvable<psize>(initial)) {
+        return std::nullopt;
+    }
+    frontier_search<psize> search;
+    return search.solve(initial);
+}
+
+}  // namespace puzzle
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <limits>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_thread_pool.h"
+
+namespace puzzle {
+
+// 64 random bits from a generator of 32 or 64 bit numbers
+template <typename Rng>
+uint64_t random_bits(Rng& rng) {
+    static_assert(Rng::min() == 0 && (Rng::max() == std::numeric_limits<uint32_t>::max() || Rng::max() == std::numeric_limits<uint64_t>::max()));
+    if constexpr (Rng::max() == std::numeric_limits<uint64_t>::max()) {
+        return rng();
+    } else {
+        const uint64_t high = rng();
+        return high << 32 | rng();
+    }
+}
+
+// the Fisher-Yates bounds n, n - 1, ..., 2 in runs whose product fits into 64 bits, the run from first down to last is read from one draw
+struct shuffle_run {
+    uint32_t first;
+    uint32_t last;
+    uint64_t product;
+};
+
+template <uint32_t n>
+inline constexpr auto shuffle_runs = [] {
+    std::array<shuffle_run, n> runs{};
+    uint32_t n_runs = 0;
+    for (uint32_t bound = n; bound > 1;) {
+        shuffle_run& run = runs[n_runs++];
+        run.first = bound;
+        run.product = 1;
+        while (bound > 1 && run.product <= std::numeric_limits<uint64_t>::max() / bound) {
+            run.product *= bound;
+            --bound;
+        }
+        run.last = bound + 1;
+    }
+    return std::pair{runs, n_runs};
+}();
+
+// uniform over the solvable boards: a shuffle of every field, and when the parity is wrong the tiles on the first two fields without the
+// empty tile trade places, which pairs every unsolvable board with exactly one solvable board; each swap of two fields flips the parity, so
+// the shuffle counts it. The indices of a run are the high halves of the draw multiplied by one bound after another, and the draw is
+// thrown away when the low half left at the end is below 2^64 mod the run's product, which keeps them exactly uniform
+template <uint32_t psize, typename Rng>
+permut_t<psize> permut_random(Rng& rng) {
+    constexpr uint32_t n = psize * psize;
+    constexpr auto& runs = shuffle_runs<n>;
+    auto arr = tiles_in_order<n>();
+    bool odd = false;
+    for (uint32_t r = 0; r < runs.second; ++r) {
+        const shuffle_run& run = runs.first[r];
+        std::array<uint32_t, n + 1> picks;
+        while (true) {
+            uint64_t rest = random_bits(rng);
+            for (uint32_t bound = run.first; bound >= run.last; --bound) {
+                const uint128_type m = static_cast<uint128_type>(rest) * bound;
+                picks[bound] = static_cast<uint32_t>(m >> 64);
+                rest = static_cast<uint64_t>(m);
+            }
+            if (rest >= run.product || rest >= -run.product % run.product) {
+                break;
+            }
+        }
+        for (uint32_t bound = run.first; bound >= run.last; --bound) {
+            if (picks[bound] != bound - 1) {
+                std::swap(arr[bound - 1], arr[picks[bound]]);
+                odd = !odd;
+            }
+        }
+    }
+    uint32_t empty_pozz = 0;
+    while (arr[empty_pozz] != n - 1) {
+        ++empty_pozz;
+    }
+    const uint32_t empty_dist = (psize - 1 - empty_pozz / psize) + (psize - 1 - empty_pozz % psize);
+    if (odd != (empty_dist % 2 == 1)) {
+        std::swap(arr[empty_pozz == 0 ? 1 : 0], arr[empty_pozz <= 1 ? 2 : 1]);
+    }
+    return permut_create<psize>(arr);
+}
+
+// no board needs more moves: the 8- and 15-puzzle diameters and the best proven upper bound for the 24-puzzle, so no admissible estimate is
+// larger either
+template <uint32_t psize>
+inline constexpr dist_type max_solution_length = psize == 3 ? 31 : psize == 4 ? 80 : 205;
+
+// a lowest estimate as parsed, nullopt above max_solution_length where no board gets it; checked before it is narrowed to dist_type,
+// which would wrap 300 to 44
+template <uint32_t psize>
+constexpr std::optional<dist_type> min_estimate_of(unsigned long value) noexcept {
+    if (value > max_solution_length<psize>) {
+        return std::nullopt;
+    }
+    return static_cast<dist_type>(value);
+}
+
+struct generator_options {
+    uint64_t seed = 0;
+    // boards estimated outside [min_estimate, max_estimate] are drawn again, the rest stay uniform
+    dist_type min_estimate = 0;
+    dist_type max_estimate = std::numeric_limits<dist_type>::max();
+    // a block gives up once it has drawn this many boards per board it keeps, plus one, so a range the estimate never or almost never
+    // reaches ends in an error instead of a search without end
+    size_t max_draws_per_instance = size_t{1} << 20;
+};
+
+template <uint32_t psize>
+struct generated_instance {
+    permut_t<psize> permut;
+    dist_type estimate;
+};
+
+// buckets of width estimates are named after the smallest one they take
+inline uint32_t estimate_bucket(dist_type estimate, uint32_t width) noexcept {
+    return estimate / width * width;
+}
+
+// count boards that depend on the seed alone: block i comes from a generator seeded with the seed and i, so the number of threads does not
+// matter; sink gets every board in order on the calling thread. Throws std::runtime_error when a block runs out of draws
+template <uint32_t psize, typename Estimate, typename Sink>
+void generate_instances(thread_pool& pool, size_t count, const generator_options& options, Estimate estimate, Sink sink) {
+    constexpr size_t block_size = 1 << 12;
+    auto generate_block = [options, estimate](size_t block, size_t size) {
+        std::seed_seq seed{static_cast<uint32_t>(options.seed), static_cast<uint32_t>(options.seed >> 32), static_cast<uint32_t>(block),
+                           static_cast<uint32_t>(static_cast<uint64_t>(block) >> 32)};
+        std::mt19937_64 src_of_randomnes(seed);
+        std::vector<generated_instance<psize>> instances;
+        instances.reserve(size);
+        for (size_t draws = 0; instances.size() < size; ++draws) {
+            if (draws >= (instances.size() + 1) * options.max_draws_per_instance) {
+                throw std::runtime_error("generate_instances: " + std::to_string(draws) + " boards drawn for " + std::to_string(instances.size()) +
+                                         " estimated within [" + std::to_string(options.min_estimate) + ", " + std::to_string(options.max_estimate) + "]");
+            }
+            const permut_t<psize> permut = permut_random<psize>(src_of_randomnes);
+            const dist_type dist = estimate(permut);
+            if (dist >= options.min_estimate && dist <= options.max_estimate) {
+                instances.push_back({permut, dist});
+            }
+        }
+        return instances;
+    };
+    std::deque<std::future<std::vector<generated_instance<psize>>>> in_flight;
+    const size_t max_in_flight = 4 * pool.size();
+    auto emit_oldest = [&] {
+        for (const generated_instance<psize>& instance : in_flight.front().get()) {
+            sink(instance);
+        }
+        in_flight.pop_front();
+    };
+    for (size_t block = 0; block * block_size < count; ++block) {
+        if (in_flight.size() == max_in_flight) {
+            emit_oldest();
+        }
+        in_flight.push_back(pool.submit([generate_block, block, size = std::min(block_size, count - block * block_size)] {
+            return generate_block(block, size);
+        }));
+    }
+    while (!in_flight.empty()) {
+        emit_oldest();
+    }
+}
+
+}  // namespace puzzle
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_arena.h"
+
+namespace puzzle {
+
+// 64 bit hash input, the high word of a 128 bit board is mixed in by a multiplication
+constexpr uint64_t permut_fold(uint64_t key) {
+    return key;
+}
+
+constexpr uint64_t permut_fold(uint128_type key) {
+    return static_cast<uint64_t>(key) ^ static_cast<uint64_t>(key >> 64) * 0xC2B2AE3D27D4EB4FULL;
+}
+
+// open addressing (linear probing) map keyed on packed permutations, nodes are kept in an arena and addressed by index
+template <typename Node, uint32_t chunk_bits = 16>
+class permut_hash_map {
+    using key_type = decltype(Node::permut);
+
+    // 4 byte slot, the key is compared in the arena
+    struct slot {
+        node_index index;
+    };
+
+    static constexpr size_t default_expected = 1 << 12;
+    // max load factor 3/4
+    static constexpr size_t load_num = 3;
+    static constexpr size_t load_den = 4;
+
+    std::vector<slot> slots;
+    node_arena<Node, chunk_bits> nodes;
+    int shift = 64;
+    size_t mask = 0;
+
+    static size_t capacity_for(size_t expected) noexcept {
+        return std::bit_ceil(std::max<size_t>(expected * load_den / load_num + 1, 16));
+    }
+    // fibonacci hashing, top bits of the product depend on every nibble
+    size_t home(key_type key) const noexcept {
+        return static_cast<size_t>((permut_fold(key) * 0x9E3779B97F4A7C15ULL) >> shift);
+    }
+    void rehash(size_t capacity) {
+        std::vector<slot> old_slots(capacity, slot{npos});
+        old_slots.swap(slots);
+        shift = 64 - std::countr_zero(capacity);
+        mask = capacity - 1;
+        for (const slot& s : old_slots) {
+            if (s.index != npos) {
+                size_t i = home(nodes[s.index].permut);
+                while (slots[i].index != npos) {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = s;
+            }
+        }
+    }
+
+public:
+    static constexpr node_index npos = ~0U;
+
+    // slots and arena chunks of a map built for expected nodes, it does not grow until it holds more
+    static size_t bytes_for(size_t expected) noexcept {
+        return capacity_for(expected) * sizeof(slot) + node_arena<Node, chunk_bits>::bytes_for(expected);
+    }
+
+    explicit permut_hash_map(size_t expected = default_expected) {
+        rehash(capacity_for(expected));
+    }
+
+    void reserve(size_t expected) {
+        if (capacity_for(expected) > slots.size()) {
+            rehash(capacity_for(expected));
+        }
+    }
+
+    node_index find(key_type key) const noexcept {
+        for (size_t i = home(key);; i = (i + 1) & mask) {
+            if (slots[i].index == npos) {
+                return npos;
+            }
+            if (nodes[slots[i].index].permut == key) {
+                return slots[i].index;
+            }
+        }
+    }
+
+    std::pair<node_index, bool> insert(const Node& node) {
+        size_t i = home(node.permut);
+        for (; slots[i].index != npos; i = (i + 1) & mask) {
+            if (nodes[slots[i].index].permut == node.permut) {
+                return {slots[i].index, false};
+            }
+        }
+        const node_index inserted = nodes.push_back(node);
+        slots[i] = slot{inserted};
+        if (nodes.size() * load_den > slots.size() * load_num) {
+            rehash(slots.size() * 2);
+        }
+        return {inserted, true};
+    }
+
+    Node& operator[](node_index i) noexcept {
+        return nodes[i];
+    }
+    const Node& operator[](node_index i) const noexcept {
+        return nodes[i];
+    }
+
+    // keeps the allocations for the next solve, a sparse table only resets the slots in use
+    void clear() {
+        if (nodes.size() * 16 < slots.size()) {
+            std::vector<size_t> used;
+            used.reserve(nodes.size());
+            for (node_index n = 0; n < nodes.size(); ++n) {
+                size_t i = home(nodes[n].permut);
+                while (slots[i].index != n) {
+                    i = (i + 1) & mask;
+                }
+                used.push_back(i);
+            }
+            for (size_t i : used) {
+                slots[i] = slot{npos};
+            }
+        } else {
+            std::fill(slots.begin(), slots.end(), slot{npos});
+        }
+        nodes.clear();
+    }
+
+    size_t size() const noexcept {
+        return nodes.size();
+    }
+
+    node_index end() const noexcept {
+        return npos;
+    }
+};
+
+}  // namespace puzzle
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_solver.h"
+
+namespace puzzle {
+
+template <typename Permut>
+struct hda_message {
+    Permut permut;
+    dist_type dist_to;
+    dist_type dist_h;
+    move_dir parent_move;
+    uint8_t blank;
+};
+
+template <typename Permut>
+struct hda_batch {
+    hda_batch* next;
+    std::vector<hda_message<Permut>> messages;
+};
+
+// lock-free multi producer single consumer inbox, producers push whole batches and the owner takes them all at once
+template <typename Batch>
+class hda_inbox {
+    std::atomic<Batch*> head = nullptr;
+
+public:
+    void push(Batch* batch) noexcept {
+        batch->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(batch->next, batch, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+    Batch* take_all() noexcept {
+        return head.exchange(nullptr, std::memory_order_acquire);
+    }
+    ~hda_inbox() {
+        Batch* batch = take_all();
+        while (batch != nullptr) {
+            delete std::exchange(batch, batch->next);
+        }
+    }
+};
+
+// hash distributed A*: every state has an owner thread that keeps it in its own open list and table
+template <uint32_t psize, typename Heuristic>
+class hda_search {
+    using permut = permut_t<psize>;
+    using hda_message = puzzle::hda_message<permut>;
+    using hda_batch = puzzle::hda_batch<permut>;
+    using queue_type = puzzle_bucket_queue_t<psize>;
+
+    static constexpr uint32_t no_solution = std::numeric_limits<uint32_t>::max();
+    static constexpr size_t batch_size = 256;
+    static constexpr size_t expansions_per_flush = 64;
+    static constexpr size_t spin_rounds = 64;
+
+    struct alignas(64) worker {
+        hda_inbox<hda_batch> inbox;
+        queue_type queue;
+        std::vector<hda_batch*> outbox;
+        size_t processed = 0;
+        // f of the best useful open node, published for the other workers
+        std::atomic<uint32_t> min_f = no_solution;
+        // bumped on every push to the inbox and whenever a parked worker has to look again
+        std::atomic<uint32_t> wakeups = 0;
+    };
+
+    const permut goal;
+    Heuristic additional;
+    std::vector<std::unique_ptr<worker>> workers;
+    std::atomic<uint32_t> best = no_solution;
+    // busy workers plus messages in flight, the search is over once it drops to zero
+    std::atomic<size_t> work = 0;
+    // workers sleeping on their wakeups
+    std::atomic<size_t> parked = 0;
+
+    size_t owner(permut p) const noexcept {
+        uint64_t key = permut_fold(p);
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return key % workers.size();
+    }
+    void send(size_t target, worker& self) {
+        hda_batch* batch = std::exchange(self.outbox[target], nullptr);
+        work += batch->messages.size();
+        workers[target]->inbox.push(batch);
+        wake(*workers[target]);
+    }
+    void flush(worker& self) {
+        for (size_t target = 0; target < workers.size(); ++target) {
+            if (self.outbox[target] != nullptr) {
+                send(target, self);
+            }
+        }
+    }
+    void relax(worker& self, const hda_message& m) {
+        queue_type& queue = self.queue;
+        const node_index n_index = queue.find(m.permut);
+        if (n_index == queue.map_end()) {
+            queue.push(m.permut, m.blank, m.parent_move, m.dist_to, m.dist_h);
+        } else if (m.dist_to < queue.node(n_index).dist_to) {
+            queue.decrease_key(n_index, m.parent_move, m.dist_to);
+        } else {
+            return;
+        }
+        if (m.permut == goal) {
+            uint32_t current_best = best.load();
+            while (m.dist_to < current_best && !best.compare_exchange_weak(current_best, m.dist_to)) {
+            }
+        }
+    }
+    // f of the top open node if it can still improve the incumbent
+    uint32_t useful_f(const worker& self) const noexcept {
+        if (self.queue.empty()) {
+            return no_solution;
+        }
+        const auto& top = self.queue.node(self.queue.top());
+        const uint32_t f = static_cast<uint32_t>(top.dist_to) + top.dist_h;
+        return f < best.load(std::memory_order_relaxed) && top.permut != goal ? f : no_solution;
+    }
+    uint32_t global_min_f() const noexcept {
+        uint32_t min_f = no_solution;
+        for (const auto& w : workers) {
+            min_f = std::min(min_f, w->min_f.load());
+        }
+        return min_f;
+    }
+    void expand(size_t own, worker& self) {
+        const auto current = self.queue.node(self.queue.top());
+        self.queue.pop();
+        ++self.processed;
+        const dist_type mdist = manhattan_dist<psize>(current.permut);
+        const dist_type additional_dist = current.dist_h - mdist;
+        permut_moves_itr<psize> neighbours(current.permut, current.blank, current.parent_move);
+        for (auto& n : neighbours) {
+            const hda_message m{n.permut, static_cast<dist_type>(current.dist_to + 1),
+                                static_cast<dist_type>(manhattan_dist_winfo<psize>(mdist, n.info) + heuristic_update(additional, current.permut, n.permut, additional_dist)),
+                                n.dir, n.blank};
+            const size_t target = owner(n.permut);
+            if (target == own) {
+                relax(self, m);
+                continue;
+            }
+            if (self.outbox[target] == nullptr) {
+                self.outbox[target] = new hda_batch{nullptr, {}};
+                self.outbox[target]->messages.reserve(batch_size);
+            }
+            self.outbox[target]->messages.push_back(m);
+            if (self.outbox[target]->messages.size() == batch_size) {
+                send(target, self);
+            }
+        }
+    }
+    void wake(worker& w) noexcept {
+        w.wakeups.fetch_add(1);
+        w.wakeups.notify_one();
+    }
+    void wake_all() noexcept {
+        for (auto& w : workers) {
+            wake(*w);
+        }
+    }
+    // a higher f can lift the bound of the workers parked ahead of it
+    void publish_min_f(worker& self, uint32_t f) noexcept {
+        const uint32_t old_f = self.min_f.load(std::memory_order_relaxed);
+        if (f == old_f) {
+            return;
+        }
+        self.min_f.store(f);
+        if (f > old_f && parked.load() != 0) {
+            wake_all();
+        }
+    }
+    void run(size_t own) {
+        worker& self = *workers[own];
+        bool busy = false;
+        size_t idle_rounds = 0;
+        while (work.load() != 0) {
+            // every push and every wake after this load ends the wait below
+            const uint32_t seen = self.wakeups.load();
+            hda_batch* batch = self.inbox.take_all();
+            if (batch != nullptr) {
+                // become busy before the messages stop counting
+                if (!busy) {
+                    ++work;
+                    busy = true;
+                }
+                while (batch != nullptr) {
+                    for (const hda_message& m : batch->messages) {
+                        relax(self, m);
+                    }
+                    work -= batch->messages.size();
+                    delete std::exchange(batch, batch->next);
+                }
+                idle_rounds = 0;
+            }
+            uint32_t f = useful_f(self);
+            publish_min_f(self, f);
+            if (f != no_solution) {
+                // workers keep to the lowest f layer, running ahead only grows the search overhead
+                const uint32_t bound = global_min_f();
+                for (size_t i = 0; i < expansions_per_flush && f <= bound; ++i, f = useful_f(self)) {
+                    expand(own, self);
+                }
+                flush(self);
+                if (f <= bound) {
+                    idle_rounds = 0;
+                    continue;
+                }
+                publish_min_f(self, f);
+            }
+            if (f == no_solution) {
+                flush(self);
+                if (busy) {
+                    busy = false;
+                    if (--work == 0) {
+                        wake_all();
+                    }
+                }
+            }
+            // nothing to do until a message comes in or the other workers finish their f layer, yield for a while and then sleep until
+            // woken; the checks after registering as parked pair with the loads of parked in publish_min_f
+            if (++idle_rounds < spin_rounds) {
+                std::this_thread::yield();
+                continue;
+            }
+            ++parked;
+            if (work.load() != 0 && (f == no_solution || f > global_min_f())) {
+                self.wakeups.wait(seen);
+            }
+            --parked;
+        }
+    }
+
+public:
+    hda_search(permut goal, Heuristic additional, size_t n_threads) : goal(goal), additional(additional) {
+        for (size_t i = 0; i < std::max<size_t>(n_threads, 1); ++i) {
+            workers.push_back(std::make_unique<worker>());
+        }
+        for (auto& w : workers) {
+            w->outbox.assign(workers.size(), nullptr);
+        }
+    }
+
+    // every solve starts from empty queues, so one search can be reused for many instances
+    std::optional<solution_t<psize>> solve(permut initial) {
+        for (auto& w : workers) {
+            w->queue.clear();
+            w->processed = 0;
+            w->min_f = no_solution;
+        }
+        best = no_solution;
+        work = 1;
+        workers[owner(initial)]->inbox.push(new hda_batch{nullptr, {{initial, 0, static_cast<dist_type>(manhattan_dist<psize>(initial) + additional(initial)), move_none, permut_blank<psize>(initial)}}});
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < workers.size(); ++i) {
+            threads.emplace_back(&hda_search::run, this, i);
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        if (best.load() == no_solution) {
+            return std::nullopt;
+        }
+        size_t touched = 0;
+        size_t processed = 0;
+        for (const auto& w : workers) {
+            touched += w->queue.map_size();
+            processed += w->processed;
+        }
+        std::vector<permut> steps;
+        permut current = goal;
+        while (current != initial) {
+            steps.push_back(current);
+            const queue_type& queue = workers[owner(current)]->queue;
+            current = permut_undo_move<psize>(current, queue.node(queue.find(current)).parent_move);
+        }
+        steps.push_back(initial);
+        return solution_t<psize>{touched, processed, std::move(steps)};
+    }
+};
+
+template <uint32_t psize, typename Heuristic>
+std::optional<solution_t<psize>> find_solution_hda(permut_t<psize> initial, Heuristic additional, size_t n_threads = std::thread::hardware_concurrency()) {
+    hda_search<psize, Heuristic> search(permut_goal<psize>, additional, n_threads);
+    return search.solve(initial);
+}
+
+}  // namespace puzzle
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "15puzzle.h"
+
+namespace puzzle {
+
+// every field value is a tile and no tile is there twice, the bits above the last field are 0
+template <uint32_t psize>
+bool permut_valid(permut_t<psize> permut) {
+    constexpr uint32_t n = psize * psize;
+    constexpr int offset = std::bit_width(n - 1);
+    if constexpr (n * offset < sizeof(permut_t<psize>) * 8) {
+        if ((permut >> (n * offset)) != 0) {
+            return false;
+        }
+    }
+    uint32_t seen = 0;
+    for (uint32_t tile : permut_to_array<psize>(permut)) {
+        if (tile >= n || (seen & (1U << tile))) {
+            return false;
+        }
+        seen |= 1U << tile;
+    }
+    return true;
+}
+
+// binary instances are packed boards in host byte order, sizeof(permut_t<psize>) bytes each without a header
+template <uint32_t psize>
+std::ostream& permut_write_binary(std::ostream& stream, permut_t<psize> permut) {
+    return stream.write(reinterpret_cast<const char*>(&permut), sizeof(permut));
+}
+
+// 0 at the end of the stream or on an invalid board
+template <uint32_t psize>
+permut_t<psize> permut_read_binary(std::istream& stream) {
+    permut_t<psize> permut = 0;
+    if (!stream.read(reinterpret_cast<char*>(&permut), sizeof(permut)) || !permut_valid<psize>(permut)) {
+        return 0;
+    }
+    return permut;
+}
+
+// a binary instance file mapped read only, for files too large to stream through a parser
+template <uint32_t psize>
+class instance_file {
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+
+public:
+    explicit instance_file(const std::string& path) {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("instance_file: cannot open " + path);
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || file_stat.st_size % sizeof(permut_t<psize>) != 0) {
+            close(fd);
+            throw std::runtime_error("instance_file: " + path + " is not a binary instance file");
+        }
+        mapping_size = file_stat.st_size;
+        if (mapping_size != 0) {
+            mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+            throw std::runtime_error("instance_file: cannot map " + path);
+        }
+        if (mapping != nullptr) {
+            madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+        }
+    }
+    instance_file(const instance_file&) = delete;
+    instance_file& operator=(const instance_file&) = delete;
+    ~instance_file() {
+        if (mapping != nullptr) {
+            munmap(mapping, mapping_size);
+        }
+    }
+
+    size_t size() const noexcept {
+        return mapping_size / sizeof(permut_t<psize>);
+    }
+    // 0 for an invalid board
+    permut_t<psize> operator[](size_t i) const noexcept {
+        permut_t<psize> permut;
+        std::memcpy(&permut, static_cast<const char*>(mapping) + i * sizeof(permut), sizeof(permut));
+        return permut_valid<psize>(permut) ? permut : 0;
+    }
+};
+
+// moves packed four to a byte, the first move in the low bits
+inline std::vector<uint8_t> moves_pack(const std::vector<move_dir>& moves) {
+    std::vector<uint8_t> packed((moves.size() + 3) / 4);
+    for (size_t i = 0; i < moves.size(); ++i) {
+        packed[i / 4] |= moves[i] << (i % 4 * 2);
+    }
+    return packed;
+}
+
+inline std::vector<move_dir> moves_unpack(const uint8_t* packed, size_t n_moves) {
+    std::vector<move_dir> moves(n_moves);
+    for (size_t i = 0; i < n_moves; ++i) {
+        moves[i] = static_cast<move_dir>((packed[i / 4] >> (i % 4 * 2)) & 3);
+    }
+    return moves;
+}
+
+// a binary solution is the move count as uint16_t in host byte order and the packed moves, the count no_solution_moves marks a board
+// without a solution
+inline constexpr uint16_t no_solution_moves = std::numeric_limits<uint16_t>::max();
+
+inline std::ostream& moves_write_binary(std::ostream& stream, const std::optional<std::vector<move_dir>>& moves) {
+    if (!moves) {
+        return stream.write(reinterpret_cast<const char*>(&no_solution_moves), sizeof(no_solution_moves));
+    }
+    if (moves->size() >= no_solution_moves) {
+        throw std::invalid_argument("moves_write_binary: too many moves");
+    }
+    const uint16_t n_moves = moves->size();
+    const std::vector<uint8_t> packed = moves_pack(*moves);
+    stream.write(reinterpret_cast<const char*>(&n_moves), sizeof(n_moves));
+    return stream.write(reinterpret_cast<const char*>(packed.data()), packed.size());
+}
+
+// false at the end of the stream, moves is empty for a board without a solution
+inline bool moves_read_binary(std::istream& stream, std::optional<std::vector<move_dir>>& moves) {
+    uint16_t n_moves;
+    if (!stream.read(reinterpret_cast<char*>(&n_moves), sizeof(n_moves))) {
+        return false;
+    }
+    if (n_moves == no_solution_moves) {
+        moves.reset();
+        return true;
+    }
+    std::vector<uint8_t> packed((n_moves + 3) / 4);
+    if (!stream.read(reinterpret_cast<char*>(packed.data()), packed.size())) {
+        return false;
+    }
+    moves = moves_unpack(packed.data(), n_moves);
+    return true;
+}
+
+// one letter per move for the direction the tile slides, indexed by move_dir
+inline constexpr char move_letters[4] = {'D', 'L', 'U', 'R'};
+
+inline std::string moves_text(const std::vector<move_dir>& moves) {
+    std::string text(moves.size(), ' ');
+    for (size_t i = 0; i < moves.size(); ++i) {
+        text[i] = move_letters[moves[i]];
+    }
+    return text;
+}
+
+}  // namespace puzzle
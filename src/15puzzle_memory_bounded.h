@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_solver.h"
+
+namespace puzzle {
+
+struct memory_limit {
+    // bytes the node table and the open list may use
+    size_t max_bytes;
+    // filled in by the solver
+    size_t max_nodes = 0;
+    // open nodes left once the table was full, the search goes on depth first below them
+    size_t frontier_nodes = 0;
+    size_t dfs_processed = 0;
+};
+
+// arena chunks of 1024 nodes, so a small limit is not taken up by one chunk
+template <uint32_t psize>
+using memory_bounded_queue_t = basic_puzzle_queue<permut_t<psize>, 10>;
+
+// what the search allocates for a cap of n nodes: the hash slots and arena chunks of the table and the heap, all reserved up front, and the
+// open nodes the depth first phase starts from
+template <uint32_t psize>
+size_t memory_bounded_bytes(size_t n) noexcept {
+    return memory_bounded_queue_t<psize>::bytes_for(n) + n * sizeof(node_index);
+}
+
+// the largest cap whose allocations fit into max_bytes, the arena alone outgrows it past max_bytes / sizeof(entry) nodes
+template <uint32_t psize>
+size_t memory_bounded_nodes(size_t max_bytes) noexcept {
+    size_t fits = 0;
+    size_t too_many = max_bytes / sizeof(basic_map_entry<permut_t<psize>>) + 1;
+    while (fits + 1 < too_many) {
+        const size_t n = fits + (too_many - fits) / 2;
+        (memory_bounded_bytes<psize>(n) <= max_bytes ? fits : too_many) = n;
+    }
+    return fits;
+}
+
+template <uint32_t psize, typename Heuristic>
+class memory_bounded_search {
+    using permut = permut_t<psize>;
+    using queue_type = memory_bounded_queue_t<psize>;
+
+    static constexpr uint32_t no_bound = std::numeric_limits<uint32_t>::max();
+
+    const permut initial;
+    Heuristic& additional;
+    memory_limit& limit;
+    const size_t max_nodes;
+    queue_type queue;
+    size_t processed = 0;
+    std::vector<permut> path;
+    uint32_t bound = 0;
+    uint32_t next_bound = no_bound;
+    // an expanded node got a shorter path, so the parent moves below it can lead back in fewer steps than their g
+    bool reopened = false;
+
+    // plain A* until the next expansion might not fit, returns the goal if it was reached first
+    node_index best_first() {
+        constexpr permut goal = permut_goal<psize>;
+        while (!queue.empty()) {
+            const node_index current = queue.top();
+            const auto& current_entry = queue.node(current);
+            if (current_entry.permut == goal) {
+                return current;
+            }
+            if (queue.map_size() + 4 > max_nodes) {
+                break;
+            }
+            ++processed;
+            queue.stats().expanded(current_entry.dist_to + current_entry.dist_h, processed, queue.map_size());
+            queue.pop();
+            const dist_type mdist = manhattan_dist<psize>(current_entry.permut);
+            const dist_type additional_dist = current_entry.dist_h - mdist;
+            permut_moves_itr<psize> neighbours(current_entry.permut, current_entry.blank, current_entry.parent_move);
+            for (auto& n : neighbours) {
+                const uint32_t dist_new = current_entry.dist_to + 1;
+                const node_index n_index = queue.find(n.permut);
+                if (n_index == queue.map_end()) {
+                    queue.push(n.permut, n.blank, n.dir, dist_new, queue.stats().heuristic([&] {
+                        return manhattan_dist_winfo<psize>(mdist, n.info) + heuristic_update(additional, current_entry.permut, n.permut, additional_dist);
+                    }));
+                } else if (dist_new < queue.node(n_index).dist_to) {
+                    reopened = reopened || queue.node(n_index).queue_index == queue_index_closed;
+                    queue.decrease_key(n_index, n.dir, dist_new);
+                }
+            }
+        }
+        return queue.map_end();
+    }
+
+    // steps of the path solution_steps rebuilds from the node
+    uint32_t rebuilt_dist(node_index i) const noexcept {
+        uint32_t dist = 0;
+        for (permut current = queue.node(i).permut; current != initial; ++dist) {
+            current = permut_undo_move<psize>(current, queue.node(i).parent_move);
+            i = queue.find(current);
+        }
+        return dist;
+    }
+
+    // IDA* below a frontier node, states the table holds with no larger g are covered by another frontier node
+    bool depth_first(uint32_t blank, move_dir previous, uint32_t dist_to, dist_type mdist, dist_type additional_dist) {
+        const permut current = path.back();
+        if (current == permut_goal<psize>) {
+            return true;
+        }
+        ++limit.dfs_processed;
+        ++processed;
+        permut_moves_itr<psize> neighbours(current, blank, previous);
+        for (auto& n : neighbours) {
+            const node_index n_index = queue.find(n.permut);
+            if (n_index != queue.map_end() && queue.node(n_index).dist_to <= dist_to + 1) {
+                continue;
+            }
+            const dist_type n_mdist = manhattan_dist_winfo<psize>(mdist, n.info);
+            const dist_type n_additional_dist = heuristic_update(additional, current, n.permut, additional_dist);
+            const uint32_t dist_f = dist_to + 1 + n_mdist + n_additional_dist;
+            if (dist_f > bound) {
+                next_bound = std::min(next_bound, dist_f);
+                continue;
+            }
+            path.push_back(n.permut);
+            if (depth_first(n.blank, n.dir, dist_to + 1, n_mdist, n_additional_dist)) {
+                return true;
+            }
+            path.pop_back();
+        }
+        return false;
+    }
+
+public:
+    memory_bounded_search(permut initial, Heuristic& additional, memory_limit& limit)
+        : initial(initial), additional(additional), limit(limit), max_nodes(memory_bounded_nodes<psize>(limit.max_bytes)), queue(max_nodes) {
+        if (max_nodes < 16) {
+            throw std::invalid_argument("memory_bounded_search: max_bytes leaves room for fewer than 16 nodes");
+        }
+        queue.reserve(max_nodes);
+        limit.max_nodes = max_nodes;
+        limit.frontier_nodes = 0;
+        limit.dfs_processed = 0;
+    }
+
+    std::optional<solution_t<psize>> solve() {
+        queue.push(initial, permut_blank<psize>(initial), move_none, 0, manhattan_dist<psize>(initial) + additional(initial));
+        const node_index goal_index = best_first();
+        if (goal_index != queue.map_end()) {
+            return solution_t<psize>{queue.map_size(), processed, solution_steps<psize>(queue, goal_index, initial), queue.stats().counters()};
+        }
+        // the open list comes out in f order
+        std::vector<node_index> frontier;
+        frontier.reserve(queue.size());
+        while (!queue.empty()) {
+            frontier.push_back(queue.top());
+            queue.pop();
+        }
+        limit.frontier_nodes = frontier.size();
+        // the depth first phase starts from g and hands out the rebuilt path, so both have to be the same length or a solution comes out
+        // longer than the bound it was found under; only a node reopened by an inconsistent heuristic can make them differ
+        auto dist_to = [this](node_index root) -> uint32_t {
+            return reopened ? rebuilt_dist(root) : queue.node(root).dist_to;
+        };
+        auto dist_f = [this, &dist_to](node_index root) {
+            return dist_to(root) + queue.node(root).dist_h;
+        };
+        if (reopened) {
+            std::sort(frontier.begin(), frontier.end(), [&dist_f](node_index a, node_index b) {
+                return dist_f(a) < dist_f(b);
+            });
+        }
+        bound = frontier.empty() ? no_bound : dist_f(frontier.front());
+        while (bound != no_bound) {
+            next_bound = no_bound;
+            for (node_index root : frontier) {
+                if (dist_f(root) > bound) {
+                    next_bound = std::min(next_bound, dist_f(root));
+                    break;
+                }
+                const auto& entry = queue.node(root);
+                const dist_type mdist = manhattan_dist<psize>(entry.permut);
+                path.assign(1, entry.permut);
+                if (depth_first(entry.blank, entry.parent_move, dist_to(root), mdist, entry.dist_h - mdist)) {
+                    std::vector<permut> steps(path.rbegin(), path.rend() - 1);
+                    const std::vector<permut> to_initial = solution_steps<psize>(queue, root, initial);
+                    steps.insert(steps.end(), to_initial.begin(), to_initial.end());
+                    return solution_t<psize>{queue.map_size(), processed, std::move(steps), queue.stats().counters()};
+                }
+            }
+            bound = next_bound;
+        }
+        return std::nullopt;
+    }
+};
+
+// A* while the nodes fit into limit.max_bytes, then IDA* from every open node, still optimal; the table, heap and frontier are allocated
+// within max_bytes, the path of the depth first phase and the allocator's overhead come on top
+template <uint32_t psize, typename Heuristic>
+std::optional<solution_t<psize>> find_solution_memory_bounded(permut_t<psize> initial, Heuristic additional, memory_limit& limit) {
+    if (!permut_solvable<psize>(initial)) {
+        return std::nullopt;
+    }
+    memory_bounded_search<psize, Heuristic> search(initial, additional, limit);
+    return search.solve();
+}
+
+}  // namespace puzzle
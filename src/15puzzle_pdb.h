@@ -0,0 +1,329 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_rank.h"
+
+namespace puzzle {
+
+// 6-6-3 and 7-8 partitions of the 15-puzzle tiles (0 based tile numbers, blank excluded)
+inline const std::vector<std::vector<uint32_t>> pdb_partition_663 = {{0, 1, 2, 4, 5, 6}, {8, 9, 10, 12, 13, 14}, {3, 7, 11}};
+inline const std::vector<std::vector<uint32_t>> pdb_partition_78 = {{0, 1, 2, 3, 4, 5, 6, 7}, {8, 9, 10, 11, 12, 13, 14}};
+
+template <uint32_t psize>
+class pdb_heuristic {
+    static constexpr uint32_t n_fields = psize * psize;
+
+    struct table_view {
+        std::array<uint8_t, n_fields> tiles;
+        uint32_t n_tiles;
+        const uint8_t* dist;
+    };
+    std::vector<table_view> tables;
+
+public:
+    void add_table(const std::vector<uint32_t>& tiles, const uint8_t* dist) {
+        table_view view{{}, static_cast<uint32_t>(tiles.size()), dist};
+        std::copy(tiles.begin(), tiles.end(), view.tiles.begin());
+        tables.push_back(view);
+    }
+
+    dist_type operator()(permut_t<psize> permut) const noexcept {
+        const auto field_of = permut_fields<psize>(permut);
+        dist_type dist = 0;
+        for (const table_view& table : tables) {
+            dist += table.dist[permut_pattern_rank<psize>(field_of, table.tiles.data(), table.n_tiles)];
+        }
+        return dist;
+    }
+};
+
+// additive disjoint pattern database, each table counts only the moves of its own tiles
+template <uint32_t psize>
+class pattern_database {
+    static constexpr uint32_t n_fields = psize * psize;
+    static constexpr uint32_t max_tiles = 8;
+    static constexpr uint32_t file_version = 1;
+    static constexpr char file_magic[8] = {'1', '5', 'P', 'Z', 'P', 'D', 'B', '\0'};
+
+    struct file_header {
+        char magic[8];
+        uint32_t version;
+        uint32_t board_size;
+        uint32_t n_patterns;
+        uint32_t reserved;
+    };
+    struct file_pattern {
+        uint64_t offset;
+        uint64_t size;
+        uint32_t n_tiles;
+        uint8_t tiles[28];
+    };
+
+    std::vector<std::vector<uint32_t>> partition;
+    std::vector<const uint8_t*> tables;
+    std::vector<std::vector<uint8_t>> owned_tables;
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+
+    static const char* partition_error(const std::vector<std::vector<uint32_t>>& partition);
+    static std::vector<uint8_t> generate_table(const std::vector<uint32_t>& tiles);
+
+public:
+    pattern_database() = default;
+    pattern_database(const pattern_database&) = delete;
+    pattern_database& operator=(const pattern_database&) = delete;
+    pattern_database(pattern_database&& other) noexcept {
+        *this = std::move(other);
+    }
+    pattern_database& operator=(pattern_database&& other) noexcept {
+        std::swap(partition, other.partition);
+        std::swap(tables, other.tables);
+        std::swap(owned_tables, other.owned_tables);
+        std::swap(mapping, other.mapping);
+        std::swap(mapping_size, other.mapping_size);
+        return *this;
+    }
+    ~pattern_database() {
+        if (mapping != nullptr) {
+            munmap(mapping, mapping_size);
+        }
+    }
+
+    static pattern_database generate(const std::vector<std::vector<uint32_t>>& partition);
+    static pattern_database load(const std::string& path);
+    void save(const std::string& path) const;
+
+    pdb_heuristic<psize> heuristic() const {
+        pdb_heuristic<psize> h;
+        for (size_t i = 0; i < partition.size(); ++i) {
+            h.add_table(partition[i], tables[i]);
+        }
+        return h;
+    }
+};
+
+// backwards breadth first search from the goal over (pattern positions, region of the empty field), moving another tile costs
+// nothing. Every rank has a 2 bit cell per field: unseen, in one of the two alternating layers, or done. Layers are found by
+// scanning all ranks, so memory stays at the cells and the table (2.6 GB for 8 tiles of the 15-puzzle) with no frontier lists.
+template <uint32_t psize>
+std::vector<uint8_t> pattern_database<psize>::generate_table(const std::vector<uint32_t>& tiles) {
+    using cell_word = std::conditional_t<(2 * n_fields <= 32), uint32_t, uint64_t>;
+    using field_set = cell_word;
+    constexpr cell_word low_bits = static_cast<cell_word>(~cell_word{0} / 3);
+    constexpr field_set all_fields = static_cast<field_set>(~field_set{0} >> (8 * sizeof(field_set) - n_fields));
+    constexpr field_set first_column = [] {
+        field_set set = 0;
+        for (uint32_t row = 0; row < psize; ++row) {
+            set |= field_set{1} << (row * psize);
+        }
+        return set;
+    }();
+    constexpr field_set last_column = first_column << (psize - 1);
+    // fields of the region around field that holds no pattern tile
+    auto region_of = [](field_set free, uint32_t field) {
+        field_set region = field_set{1} << field;
+        for (field_set grown = 0; grown != region;) {
+            grown = region;
+            region |= ((region << psize) | (region >> psize) | ((region << 1) & ~first_column) | ((region >> 1) & ~last_column)) & free;
+        }
+        return region;
+    };
+    // one 2 bit cell per field, from a set with one bit per field
+    auto spread = [](field_set set) {
+        cell_word cells = 0;
+        for (; set != 0; set &= set - 1) {
+            cells |= cell_word{1} << (2 * std::countr_zero(set));
+        }
+        return cells;
+    };
+
+    const uint32_t k = std::clamp<uint32_t>(tiles.size(), 1, max_tiles);
+    const uint64_t size = pattern_size(k, n_fields);
+    std::vector<uint8_t> dist(size, 0xff);
+    std::vector<cell_word> cells(size, 0);
+    constexpr cell_word done = 3;
+    cell_word current = 1;
+    cell_word next = 2;
+
+    std::array<uint8_t, max_tiles> positions;
+    field_set occupied = 0;
+    for (uint32_t i = 0; i < k; ++i) {
+        positions[i] = tiles[i];
+        occupied |= field_set{1} << tiles[i];
+    }
+    const uint64_t goal = pattern_rank(positions.data(), k, n_fields);
+    cells[goal] = spread(region_of(all_fields & ~occupied, n_fields - 1)) * current;
+    dist[goal] = 0;
+    for (uint8_t cost = 0;; ++cost) {
+        bool found = false;
+        for (uint64_t rank = 0; rank < size; ++rank) {
+            // cells holding the current layer, as their low bits
+            const cell_word word = cells[rank];
+            const cell_word layer = (current == 1 ? word & ~(word >> 1) : (word >> 1) & ~word) & low_bits;
+            if (layer == 0) {
+                continue;
+            }
+            cells[rank] = word | layer * done;
+            pattern_unrank(rank, k, n_fields, positions.data());
+            std::array<int, n_fields> occupant;
+            occupant.fill(-1);
+            occupied = 0;
+            for (uint32_t i = 0; i < k; ++i) {
+                occupant[positions[i]] = i;
+                occupied |= field_set{1} << positions[i];
+            }
+            // the empty field moves a pattern tile next to its region, the tile's old field starts a new region
+            for (cell_word rest = layer; rest != 0; rest &= rest - 1) {
+                const uint32_t field = std::countr_zero(rest) / 2;
+                const field_set around = ((field_set{1} << field << psize) | (field_set{1} << field >> psize) |
+                                          ((field_set{1} << field << 1) & ~first_column) | ((field_set{1} << field >> 1) & ~last_column)) &
+                                         occupied;
+                for (field_set from = around; from != 0; from &= from - 1) {
+                    const uint32_t n = std::countr_zero(from);
+                    std::array<uint8_t, max_tiles> moved = positions;
+                    moved[occupant[n]] = field;
+                    const uint64_t moved_rank = pattern_rank(moved.data(), k, n_fields);
+                    if (((cells[moved_rank] >> (2 * n)) & done) != 0) {
+                        continue;
+                    }
+                    const field_set moved_free = all_fields & ~(occupied ^ (field_set{1} << n) ^ (field_set{1} << field));
+                    cells[moved_rank] |= spread(region_of(moved_free, n)) * next;
+                    dist[moved_rank] = std::min<uint8_t>(dist[moved_rank], cost + 1);
+                    found = true;
+                }
+            }
+        }
+        if (!found) {
+            break;
+        }
+        std::swap(current, next);
+    }
+    return dist;
+}
+
+// nullptr when generate and load can take the partition
+template <uint32_t psize>
+const char* pattern_database<psize>::partition_error(const std::vector<std::vector<uint32_t>>& partition) {
+    uint32_t used = 0;
+    for (const auto& tiles : partition) {
+        if (tiles.empty() || tiles.size() > max_tiles) {
+            return "a pattern needs 1 to 8 tiles";
+        }
+        for (uint32_t tile : tiles) {
+            if (tile >= n_fields - 1 || (used & (1U << tile))) {
+                return "patterns must be disjoint tile sets";
+            }
+            used |= 1U << tile;
+        }
+    }
+    return nullptr;
+}
+
+template <uint32_t psize>
+pattern_database<psize> pattern_database<psize>::generate(const std::vector<std::vector<uint32_t>>& partition) {
+    if (const char* error = partition_error(partition)) {
+        throw std::invalid_argument(std::string("pattern_database: ") + error);
+    }
+    pattern_database db;
+    db.partition = partition;
+    for (const auto& tiles : partition) {
+        db.owned_tables.push_back(generate_table(tiles));
+        db.tables.push_back(db.owned_tables.back().data());
+    }
+    return db;
+}
+
+template <uint32_t psize>
+void pattern_database<psize>::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("pattern_database: cannot open " + path);
+    }
+    file_header header{{}, file_version, psize, static_cast<uint32_t>(partition.size()), 0};
+    std::memcpy(header.magic, file_magic, sizeof(file_magic));
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t offset = sizeof(file_header) + partition.size() * sizeof(file_pattern);
+    for (const auto& tiles : partition) {
+        // tables start on a cache line
+        offset = (offset + 63) / 64 * 64;
+        file_pattern descriptor{offset, pattern_size(tiles.size(), n_fields), static_cast<uint32_t>(tiles.size()), {}};
+        std::copy(tiles.begin(), tiles.end(), descriptor.tiles);
+        file.write(reinterpret_cast<const char*>(&descriptor), sizeof(descriptor));
+        offset += descriptor.size;
+    }
+    for (size_t i = 0; i < partition.size(); ++i) {
+        const uint64_t aligned = (static_cast<uint64_t>(file.tellp()) + 63) / 64 * 64;
+        while (static_cast<uint64_t>(file.tellp()) < aligned) {
+            file.put('\0');
+        }
+        file.write(reinterpret_cast<const char*>(tables[i]), pattern_size(partition[i].size(), n_fields));
+    }
+    if (!file) {
+        throw std::runtime_error("pattern_database: cannot write " + path);
+    }
+}
+
+// the tables stay in the page cache and are shared by every process mapping the same file
+template <uint32_t psize>
+pattern_database<psize> pattern_database<psize>::load(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("pattern_database: cannot open " + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(file_header)) {
+        close(fd);
+        throw std::runtime_error("pattern_database: " + path + " is not a pattern database");
+    }
+    pattern_database db;
+    db.mapping_size = file_stat.st_size;
+    db.mapping = mmap(nullptr, db.mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (db.mapping == MAP_FAILED) {
+        db.mapping = nullptr;
+        throw std::runtime_error("pattern_database: cannot map " + path);
+    }
+    const auto* bytes = static_cast<const uint8_t*>(db.mapping);
+    file_header header;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0 || header.version != file_version || header.board_size != psize ||
+        sizeof(file_header) + header.n_patterns * sizeof(file_pattern) > db.mapping_size) {
+        throw std::runtime_error("pattern_database: " + path + " has a wrong header");
+    }
+    for (uint32_t i = 0; i < header.n_patterns; ++i) {
+        file_pattern descriptor;
+        std::memcpy(&descriptor, bytes + sizeof(file_header) + i * sizeof(file_pattern), sizeof(descriptor));
+        if (descriptor.n_tiles == 0 || descriptor.n_tiles > max_tiles || descriptor.size != pattern_size(descriptor.n_tiles, n_fields) ||
+            descriptor.offset > db.mapping_size || descriptor.size > db.mapping_size - descriptor.offset) {
+            throw std::runtime_error("pattern_database: " + path + " is truncated");
+        }
+        db.partition.emplace_back(descriptor.tiles, descriptor.tiles + descriptor.n_tiles);
+        db.tables.push_back(bytes + descriptor.offset);
+    }
+    // the heuristic indexes its tables with the tiles, a file has to hold the same partitions generate takes
+    if (const char* error = partition_error(db.partition)) {
+        throw std::runtime_error("pattern_database: " + path + ": " + error);
+    }
+    return db;
+}
+
+}  // namespace puzzle
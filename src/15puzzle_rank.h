@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "15puzzle.h"
+
+namespace puzzle {
+
+// (psize * psize)!, the number of values permut_rank maps to
+template <uint32_t psize>
+constexpr uint64_t permut_rank_size() {
+    static_assert(psize <= 4, "(psize * psize)! has to fit into 64 bits");
+    uint64_t size = 1;
+    for (uint32_t i = 2; i <= psize * psize; ++i) {
+        size *= i;
+    }
+    return size;
+}
+
+// field of every tile, [tile] -> field in reading order
+template <uint32_t psize>
+constexpr std::array<uint8_t, psize * psize> permut_fields(permut_t<psize> permut) {
+    constexpr int offset = std::bit_width(psize * psize - 1);
+    constexpr permut_t<psize> mask = ~(~0U << offset);
+    std::array<uint8_t, psize * psize> field_of{};
+    for (uint32_t pozz = psize * psize - 1; pozz != static_cast<uint32_t>(-1); --pozz) {
+        field_of[static_cast<uint32_t>(permut & mask)] = pozz;
+        permut >>= offset;
+    }
+    return field_of;
+}
+
+// Myrvold and Ruskey's linear time rank, not lexicographic but a bijection of all boards onto [0, (psize * psize)!)
+template <uint32_t psize>
+constexpr uint64_t permut_rank(permut_t<psize> permut) {
+    static_assert(psize <= 4, "(psize * psize)! has to fit into 64 bits");
+    constexpr uint32_t n = psize * psize;
+    constexpr int offset = std::bit_width(n - 1);
+    constexpr permut_t<psize> mask = ~(~0U << offset);
+    std::array<uint8_t, n> tiles{};
+    std::array<uint8_t, n> field_of{};
+    for (uint32_t pozz = n - 1; pozz != static_cast<uint32_t>(-1); --pozz) {
+        tiles[pozz] = permut & mask;
+        field_of[tiles[pozz]] = pozz;
+        permut >>= offset;
+    }
+    uint64_t rank = 0;
+    uint64_t radix = 1;
+    for (uint32_t len = n; len > 1; --len) {
+        const uint8_t last = tiles[len - 1];
+        std::swap(tiles[len - 1], tiles[field_of[len - 1]]);
+        std::swap(field_of[last], field_of[len - 1]);
+        rank += last * radix;
+        radix *= len;
+    }
+    return rank;
+}
+
+template <uint32_t psize>
+constexpr permut_t<psize> permut_unrank(uint64_t rank) {
+    constexpr uint32_t n = psize * psize;
+    auto tiles = tiles_in_order<n>();
+    for (uint32_t len = n; len > 1; --len) {
+        std::swap(tiles[len - 1], tiles[rank % len]);
+        rank /= len;
+    }
+    return permut_create<psize>(tiles);
+}
+
+// the states are independent, so the loop keeps several rank chains in flight
+template <uint32_t psize>
+void permut_rank_batch(const permut_t<psize>* permuts, size_t n, uint64_t* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = permut_rank<psize>(permuts[i]);
+    }
+}
+
+template <uint32_t psize>
+void permut_unrank_batch(const uint64_t* ranks, size_t n, permut_t<psize>* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = permut_unrank<psize>(ranks[i]);
+    }
+}
+
+// n * (n - 1) * ... * (n - k + 1), the number of values pattern_rank maps to
+constexpr uint64_t pattern_size(uint32_t k, uint32_t n) noexcept {
+    uint64_t size = 1;
+    for (uint32_t i = 0; i < k; ++i) {
+        size *= n - i;
+    }
+    return size;
+}
+
+// rank of k distinct positions (out of n <= 32) in the mixed radix n * (n - 1) * ... * (n - k + 1)
+constexpr uint64_t pattern_rank(const uint8_t* positions, uint32_t k, uint32_t n) noexcept {
+    uint64_t rank = 0;
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < k; ++i) {
+        const uint32_t position = positions[i];
+        rank = rank * (n - i) + position - std::popcount(used & ((1U << position) - 1));
+        used |= 1U << position;
+    }
+    return rank;
+}
+
+constexpr void pattern_unrank(uint64_t rank, uint32_t k, uint32_t n, uint8_t* positions) noexcept {
+    // digits from the last one, each is the index among the positions still free
+    for (uint32_t i = k; i-- > 0;) {
+        positions[i] = rank % (n - i);
+        rank /= n - i;
+    }
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < k; ++i) {
+        uint32_t free = ~used;
+        for (uint32_t skip = positions[i]; skip > 0; --skip) {
+            free &= free - 1;
+        }
+        positions[i] = std::countr_zero(free);
+        used |= 1U << positions[i];
+    }
+}
+
+// rank of the fields of the given tiles
+template <uint32_t psize>
+constexpr uint64_t permut_pattern_rank(const std::array<uint8_t, psize * psize>& field_of, const uint8_t* tiles, uint32_t k) noexcept {
+    std::array<uint8_t, psize * psize> positions{};
+    for (uint32_t i = 0; i < k; ++i) {
+        positions[i] = field_of[tiles[i]];
+    }
+    return pattern_rank(positions.data(), k, psize * psize);
+}
+
+}  // namespace puzzle
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "15puzzle.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define PUZZLE_X86_SIMD 1
+#endif
+
+namespace puzzle {
+
+template <uint32_t psize>
+void manhattan_dist_batch_scalar(const permut_t<psize>* permuts, size_t n, dist_type* out) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = manhattan_dist<psize>(permuts[i]);
+    }
+}
+
+#ifdef PUZZLE_X86_SIMD
+
+// byte lanes for the nibble kernels: lane j holds the tile on field psize * psize - 1 - j
+template <uint32_t psize>
+struct manhattan_simd_tables {
+    alignas(16) std::array<uint8_t, 16> row_of{};
+    alignas(16) std::array<uint8_t, 16> col_of{};
+    alignas(16) std::array<uint8_t, 16> lane_row{};
+    alignas(16) std::array<uint8_t, 16> lane_col{};
+
+    // lanes past the board hold tile 0 and get row and column 0, so they add nothing
+    constexpr manhattan_simd_tables() {
+        for (uint32_t tile = 0; tile < psize * psize; ++tile) {
+            row_of[tile] = tile / psize;
+            col_of[tile] = tile % psize;
+        }
+        for (uint32_t lane = 0; lane < psize * psize; ++lane) {
+            const uint32_t pozz = psize * psize - 1 - lane;
+            lane_row[lane] = pozz / psize;
+            lane_col[lane] = pozz % psize;
+        }
+    }
+};
+
+template <uint32_t psize>
+inline constexpr manhattan_simd_tables<psize> manhattan_simd{};
+
+template <uint32_t psize>
+[[gnu::target("ssse3")]] void manhattan_dist_batch_ssse3(const permut_t<psize>* permuts, size_t n, dist_type* out) {
+    static_assert(std::bit_width(psize * psize - 1) == 4, "the kernel works on nibbles");
+    const __m128i row_of = _mm_load_si128(reinterpret_cast<const __m128i*>(manhattan_simd<psize>.row_of.data()));
+    const __m128i col_of = _mm_load_si128(reinterpret_cast<const __m128i*>(manhattan_simd<psize>.col_of.data()));
+    const __m128i lane_row = _mm_load_si128(reinterpret_cast<const __m128i*>(manhattan_simd<psize>.lane_row.data()));
+    const __m128i lane_col = _mm_load_si128(reinterpret_cast<const __m128i*>(manhattan_simd<psize>.lane_col.data()));
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i empty = _mm_set1_epi8(psize * psize - 1);
+    for (size_t i = 0; i < n; ++i) {
+        const __m128i packed = _mm_cvtsi64_si128(static_cast<long long>(permuts[i]));
+        const __m128i tiles = _mm_unpacklo_epi8(_mm_and_si128(packed, nibble), _mm_and_si128(_mm_srli_epi16(packed, 4), nibble));
+        const __m128i rows = _mm_abs_epi8(_mm_sub_epi8(_mm_shuffle_epi8(row_of, tiles), lane_row));
+        const __m128i cols = _mm_abs_epi8(_mm_sub_epi8(_mm_shuffle_epi8(col_of, tiles), lane_col));
+        const __m128i dist = _mm_andnot_si128(_mm_cmpeq_epi8(tiles, empty), _mm_add_epi8(rows, cols));
+        const __m128i sums = _mm_sad_epu8(dist, _mm_setzero_si128());
+        out[i] = _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+    }
+}
+
+// four states per iteration, 128 bit lanes take states 0 and 2 in one register and 1 and 3 in the other
+template <uint32_t psize>
+[[gnu::target("avx2")]] void manhattan_dist_batch_avx2(const permut_t<psize>* permuts, size_t n, dist_type* out) {
+    static_assert(std::bit_width(psize * psize - 1) == 4, "the kernel works on nibbles");
+    const __m256i row_of = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(manhattan_simd<psize>.row_of.data())));
+    const __m256i col_of = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(manhattan_simd<psize>.col_of.data())));
+    const __m256i lane_row = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(manhattan_simd<psize>.lane_row.data())));
+    const __m256i lane_col = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(manhattan_simd<psize>.lane_col.data())));
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i empty = _mm256_set1_epi8(psize * psize - 1);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(permuts + i));
+        const __m256i low = _mm256_and_si256(packed, nibble);
+        const __m256i high = _mm256_and_si256(_mm256_srli_epi16(packed, 4), nibble);
+        // per 128 bit lane: states 0 and 2, states 1 and 3, both are replaced by their partial sums
+        __m256i halves[2] = {_mm256_unpacklo_epi8(low, high), _mm256_unpackhi_epi8(low, high)};
+        for (__m256i& half : halves) {
+            const __m256i tiles = half;
+            const __m256i rows = _mm256_abs_epi8(_mm256_sub_epi8(_mm256_shuffle_epi8(row_of, tiles), lane_row));
+            const __m256i cols = _mm256_abs_epi8(_mm256_sub_epi8(_mm256_shuffle_epi8(col_of, tiles), lane_col));
+            const __m256i dist = _mm256_andnot_si256(_mm256_cmpeq_epi8(tiles, empty), _mm256_add_epi8(rows, cols));
+            half = _mm256_sad_epu8(dist, _mm256_setzero_si256());
+        }
+        // adjacent 64 bit partial sums belong to one state
+        const __m256i sums = _mm256_add_epi64(_mm256_unpacklo_epi64(halves[0], halves[1]), _mm256_unpackhi_epi64(halves[0], halves[1]));
+        out[i] = _mm256_extract_epi64(sums, 0);
+        out[i + 1] = _mm256_extract_epi64(sums, 1);
+        out[i + 2] = _mm256_extract_epi64(sums, 2);
+        out[i + 3] = _mm256_extract_epi64(sums, 3);
+    }
+    manhattan_dist_batch_ssse3<psize>(permuts + i, n - i, out + i);
+}
+
+#endif
+
+// manhattan distance of n states, picks the widest kernel the cpu supports on first use
+template <uint32_t psize>
+void manhattan_dist_batch(const permut_t<psize>* permuts, size_t n, dist_type* out) {
+#ifdef PUZZLE_X86_SIMD
+    if constexpr (std::bit_width(psize * psize - 1) == 4) {
+        using kernel = void (*)(const permut_t<psize>*, size_t, dist_type*);
+        static const kernel best = []() -> kernel {
+            if (__builtin_cpu_supports("avx2")) {
+                return manhattan_dist_batch_avx2<psize>;
+            }
+            if (__builtin_cpu_supports("ssse3")) {
+                return manhattan_dist_batch_ssse3<psize>;
+            }
+            return manhattan_dist_batch_scalar<psize>;
+        }();
+        best(permuts, n, out);
+        return;
+    }
+#endif
+    manhattan_dist_batch_scalar<psize>(permuts, n, out);
+}
+
+// manhattan distance of every neighbour at once, out needs room for 4 values
+template <uint32_t psize>
+unsigned manhattan_dist_neighbors(permut_neighbors_itr_winfo<psize>& neighbours, dist_type* out) {
+    std::array<permut_t<psize>, 4> permuts{};
+    unsigned len = 0;
+    for (auto& n : neighbours) {
+        permuts[len++] = n.first;
+    }
+    manhattan_dist_batch<psize>(permuts.data(), len, out);
+    return len;
+}
+
+}  // namespace puzzle
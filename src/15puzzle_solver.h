@@ -1,40 +1,55 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
-#include <map>
+#include <limits>
 #include <optional>
+#include <utility>
 #include <vector>
 
 #include "15puzzle.h"
+#include "15puzzle_hash_map.h"
+#include "15puzzle_stats.h"
 
 namespace puzzle {
 
-struct map_entry;
-using map_iterator = std::map<permut_type, map_entry>::iterator;
+// queue_index of an expanded node
+constexpr uint32_t queue_index_closed = ~0U;
 
-struct map_entry {
-    map_iterator parent;
+template <typename Permut>
+struct basic_map_entry {
+    Permut permut;
     uint32_t queue_index;
     dist_type dist_to;
     dist_type dist_h;
+    move_dir parent_move;
+    // field of the empty tile, saves the search for it on every expansion
+    uint8_t blank;
 };
 
-bool comp(map_iterator lhs, map_iterator rhs) {
-    auto sum_l = lhs->second.dist_to + lhs->second.dist_h;
-    auto sum_r = rhs->second.dist_to + rhs->second.dist_h;
-    if (sum_l < sum_r) {
-        return true;
-    } else if (sum_l == sum_r) {
-        return lhs->second.dist_h < rhs->second.dist_h;
-    } else {
-        return false;
-    }
-}
+using map_entry = basic_map_entry<permut_type>;
+
+template <typename Permut, uint32_t chunk_bits = 16>
+class basic_puzzle_queue {
+    using map_entry = basic_map_entry<Permut>;
 
-class puzzle_queue {
-    std::vector<map_iterator> permut_queue;
-    std::map<permut_type, map_entry> permut_map;
+    std::vector<node_index> permut_queue;
+    permut_hash_map<map_entry, chunk_bits> permut_map;
+    [[no_unique_address]] mutable search_stats queue_stats;
 
+    bool comp(node_index lhs, node_index rhs) const noexcept {
+        const map_entry& l_entry = permut_map[lhs];
+        const map_entry& r_entry = permut_map[rhs];
+        auto sum_l = l_entry.dist_to + l_entry.dist_h;
+        auto sum_r = r_entry.dist_to + r_entry.dist_h;
+        if (sum_l < sum_r) {
+            return true;
+        } else if (sum_l == sum_r) {
+            return l_entry.dist_h < r_entry.dist_h;
+        } else {
+            return false;
+        }
+    }
     static inline size_t left_child(size_t root) noexcept {
         return 2 * root + 1;
     }
@@ -44,19 +59,23 @@ class puzzle_queue {
     static inline size_t parent(size_t child) noexcept {
         return (child - 1) / 2;
     }
+    void swap_entries(size_t a, size_t b) noexcept {
+        queue_stats.sift_step();
+        std::swap(permut_map[permut_queue[a]].queue_index, permut_map[permut_queue[b]].queue_index);
+        std::swap(permut_queue[a], permut_queue[b]);
+    }
     void heapify(size_t root) noexcept {
-        auto l = puzzle_queue::left_child(root);
-        auto r = puzzle_queue::right_child(root);
+        auto l = basic_puzzle_queue::left_child(root);
+        auto r = basic_puzzle_queue::right_child(root);
         size_t top = root;
-        if (l <= permut_queue.size() && comp(permut_queue[l], permut_queue[root])) {
+        if (l < permut_queue.size() && comp(permut_queue[l], permut_queue[root])) {
             top = l;
         }
-        if (r <= permut_queue.size() && comp(permut_queue[r], permut_queue[top])) {
+        if (r < permut_queue.size() && comp(permut_queue[r], permut_queue[top])) {
             top = r;
         }
         if (root != top) {
-            std::swap(permut_queue[root]->second.queue_index, permut_queue[top]->second.queue_index);
-            std::swap(permut_queue[root], permut_queue[top]);
+            swap_entries(root, top);
             heapify(top);
         }
     }
@@ -65,97 +84,317 @@ class puzzle_queue {
             heapify(i);
         }
     }
+    void sift_up(size_t i) noexcept {
+        while (i > 0 && comp(permut_queue[i], permut_queue[basic_puzzle_queue::parent(i)])) {
+            swap_entries(i, basic_puzzle_queue::parent(i));
+            i = basic_puzzle_queue::parent(i);
+        }
+    }
 
 public:
-    void push(permut_type entry, map_iterator parent, dist_type dist_to, dist_type dist_from) {
+    basic_puzzle_queue() = default;
+    explicit basic_puzzle_queue(size_t expected_nodes) : permut_map(expected_nodes) {
+        permut_queue.reserve(expected_nodes / 2);
+    }
+
+    // table and heap of a queue that holds up to n nodes after reserve(n)
+    static size_t bytes_for(size_t n) noexcept {
+        return permut_hash_map<map_entry, chunk_bits>::bytes_for(n) + n * sizeof(node_index);
+    }
+    void reserve(size_t n) {
+        permut_map.reserve(n);
+        permut_queue.reserve(n);
+    }
+
+    void push(Permut entry, uint8_t blank, move_dir parent_move, dist_type dist_to, dist_type dist_from) {
         size_t i = permut_queue.size();
-        map_iterator current_m_entry = permut_map.insert(std::pair{entry, map_entry{parent, static_cast<uint32_t>(i), dist_to, dist_from}}).first;
-        permut_queue.push_back(current_m_entry);
-        while (i > 0 && comp(permut_queue[i], permut_queue[puzzle_queue::parent(i)])) {
-            map_iterator parent_m_entry = permut_queue[puzzle_queue::parent(i)];
-            std::swap(current_m_entry->second.queue_index, parent_m_entry->second.queue_index);
-            std::swap(permut_queue[i], permut_queue[puzzle_queue::parent(i)]);
-            i = puzzle_queue::parent(i);
-            current_m_entry = parent_m_entry;
-        }
+        permut_queue.push_back(permut_map.insert(map_entry{entry, static_cast<uint32_t>(i), dist_to, dist_from, parent_move, blank}).first);
+        sift_up(i);
     }
-    const map_iterator& top() const noexcept {
+    node_index top() const noexcept {
         return permut_queue[0];
     }
     void pop() noexcept {
+        permut_map[permut_queue[0]].queue_index = queue_index_closed;
         permut_queue[0] = permut_queue.back();
         permut_queue.pop_back();
-        heapify(0);
+        if (!permut_queue.empty()) {
+            permut_map[permut_queue[0]].queue_index = 0;
+            heapify(0);
+        }
     }
     bool empty() const noexcept {
         return permut_queue.empty();
     }
-    void decrease_key(map_iterator current_m_entry, map_iterator parent_new, dist_type dist_to_new) {
-        size_t i = current_m_entry->second.queue_index;
-        current_m_entry->second.dist_to = dist_to_new;
-        current_m_entry->second.parent = parent_new;
-        while (i > 0 && comp(permut_queue[i], permut_queue[puzzle_queue::parent(i)])) {
-            map_iterator parent_m_entry = permut_queue[puzzle_queue::parent(i)];
-            std::swap(current_m_entry->second.queue_index, parent_m_entry->second.queue_index);
-            std::swap(permut_queue[i], permut_queue[puzzle_queue::parent(i)]);
-            i = puzzle_queue::parent(i);
-            current_m_entry = parent_m_entry;
+    size_t size() const noexcept {
+        return permut_queue.size();
+    }
+    // the same with a new heuristic value, for searches whose heuristic changes while nodes are closed
+    void decrease_key(node_index current, move_dir parent_move_new, dist_type dist_to_new, dist_type dist_h_new) {
+        permut_map[current].dist_h = dist_h_new;
+        decrease_key(current, parent_move_new, dist_to_new);
+    }
+    // reopens the node if it was expanded already
+    void decrease_key(node_index current, move_dir parent_move_new, dist_type dist_to_new) {
+        const bool reopened = permut_map[current].queue_index == queue_index_closed;
+        queue_stats.decrease_key(reopened);
+        permut_map[current].dist_to = dist_to_new;
+        permut_map[current].parent_move = parent_move_new;
+        if (reopened) {
+            permut_map[current].queue_index = permut_queue.size();
+            permut_queue.push_back(current);
+        }
+        sift_up(permut_map[current].queue_index);
+    }
+    // sets dist_h of every open node to new_dist_h(node), for searches that change their heuristic between rounds
+    template <typename F>
+    void update_open(F&& new_dist_h) {
+        for (node_index i : permut_queue) {
+            permut_map[i].dist_h = new_dist_h(std::as_const(permut_map[i]));
+        }
+        build_heap();
+    }
+
+    node_index find(Permut element) const noexcept {
+        const node_index found = permut_map.find(element);
+        queue_stats.lookup(found != permut_map.end());
+        return found;
+    }
+
+    search_stats& stats() noexcept {
+        return queue_stats;
+    }
+
+    const map_entry& node(node_index i) const noexcept {
+        return permut_map[i];
+    }
+
+    size_t map_size() const noexcept {
+        return permut_map.size();
+    }
+
+    node_index map_end() const noexcept {
+        return permut_map.end();
+    }
+
+    void clear() {
+        permut_queue.clear();
+        permut_map.clear();
+        queue_stats.reset();
+    }
+};
+
+using puzzle_queue = basic_puzzle_queue<permut_type>;
+
+template <uint32_t psize>
+using puzzle_queue_t = basic_puzzle_queue<permut_t<psize>>;
+
+// open list as buckets indexed by f and then h, decrease_key leaves the old entry behind and it is skipped once reached
+template <typename Permut>
+class basic_puzzle_bucket_queue {
+    using map_entry = basic_map_entry<Permut>;
+
+    struct bucket_entry {
+        node_index index;
+        dist_type dist_to;
+    };
+    using bucket = std::vector<bucket_entry>;
+
+    std::vector<std::vector<bucket>> buckets;
+    permut_hash_map<map_entry> permut_map;
+    [[no_unique_address]] mutable search_stats queue_stats;
+    size_t queue_size = 0;
+    size_t top_f = 0;
+    size_t top_h = 0;
+
+    bool stale(const bucket_entry& b_entry) const noexcept {
+        return b_entry.dist_to != permut_map[b_entry.index].dist_to;
+    }
+    void insert(node_index current) {
+        map_entry& m_entry = permut_map[current];
+        m_entry.queue_index = 0;
+        const size_t f = m_entry.dist_to + m_entry.dist_h;
+        const size_t h = m_entry.dist_h;
+        if (f >= buckets.size()) {
+            buckets.resize(f + 1);
         }
+        if (h >= buckets[f].size()) {
+            buckets[f].resize(h + 1);
+        }
+        buckets[f][h].push_back(bucket_entry{current, m_entry.dist_to});
+        if (queue_size == 0 || f < top_f || (f == top_f && h < top_h)) {
+            top_f = f;
+            top_h = h;
+        }
+        ++queue_size;
+    }
+    // moves the cursor to the first live entry
+    void settle() noexcept {
+        while (queue_size > 0) {
+            if (top_h >= buckets[top_f].size()) {
+                ++top_f;
+                top_h = 0;
+                continue;
+            }
+            bucket& current = buckets[top_f][top_h];
+            while (!current.empty() && stale(current.back())) {
+                current.pop_back();
+                --queue_size;
+            }
+            if (!current.empty()) {
+                return;
+            }
+            ++top_h;
+        }
+    }
+
+public:
+    basic_puzzle_bucket_queue() = default;
+    explicit basic_puzzle_bucket_queue(size_t expected_nodes) : permut_map(expected_nodes) {}
+
+    void push(Permut entry, uint8_t blank, move_dir parent_move, dist_type dist_to, dist_type dist_from) {
+        insert(permut_map.insert(map_entry{entry, 0, dist_to, dist_from, parent_move, blank}).first);
+    }
+    node_index top() const noexcept {
+        return buckets[top_f][top_h].back().index;
+    }
+    void pop() noexcept {
+        permut_map[top()].queue_index = queue_index_closed;
+        buckets[top_f][top_h].pop_back();
+        --queue_size;
+        settle();
+    }
+    bool empty() const noexcept {
+        return queue_size == 0;
+    }
+    // the same with a new heuristic value, for searches whose heuristic changes while nodes are closed
+    void decrease_key(node_index current, move_dir parent_move_new, dist_type dist_to_new, dist_type dist_h_new) {
+        permut_map[current].dist_h = dist_h_new;
+        decrease_key(current, parent_move_new, dist_to_new);
+    }
+    void decrease_key(node_index current, move_dir parent_move_new, dist_type dist_to_new) {
+        queue_stats.decrease_key(permut_map[current].queue_index == queue_index_closed);
+        permut_map[current].dist_to = dist_to_new;
+        permut_map[current].parent_move = parent_move_new;
+        insert(current);
     }
 
-    map_iterator find(permut_type element) {
-        return permut_map.find(element);
+    node_index find(Permut element) const noexcept {
+        const node_index found = permut_map.find(element);
+        queue_stats.lookup(found != permut_map.end());
+        return found;
+    }
+
+    search_stats& stats() noexcept {
+        return queue_stats;
+    }
+
+    const map_entry& node(node_index i) const noexcept {
+        return permut_map[i];
     }
 
     size_t map_size() const noexcept {
         return permut_map.size();
     }
 
-    map_iterator map_end() noexcept {
+    node_index map_end() const noexcept {
         return permut_map.end();
     }
+
+    void clear() {
+        for (auto& f_buckets : buckets) {
+            for (auto& h_bucket : f_buckets) {
+                h_bucket.clear();
+            }
+        }
+        queue_size = 0;
+        permut_map.clear();
+        queue_stats.reset();
+    }
 };
 
-struct solution {
+using puzzle_bucket_queue = basic_puzzle_bucket_queue<permut_type>;
+
+template <uint32_t psize>
+using puzzle_bucket_queue_t = basic_puzzle_bucket_queue<permut_t<psize>>;
+
+template <typename Permut>
+struct basic_solution {
     size_t touched;
     size_t processed;
-    std::vector<permut_type> steps;
+    std::vector<Permut> steps;
+    // empty unless built with PUZZLE_STATS
+    [[no_unique_address]] search_counters stats{};
+    // proven ratio of steps to the optimum, 1 for the optimal solvers
+    double bound = 1.0;
 };
 
-template <uint32_t psize, typename Heuristic>
-std::optional<solution> find_solution(permut_type initial, Heuristic heuristic_dist) {
-    constexpr auto create_goal = []() -> permut_type {
-        if constexpr (psize == 3) {
-            return permut_create<psize>({0, 1, 2, 3, 4, 5, 6, 7, 8});
-        }
-        return permut_create<psize>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15});
-    };
-    constexpr permut_type goal = create_goal();
+using solution = basic_solution<permut_type>;
+
+template <uint32_t psize>
+using solution_t = basic_solution<permut_t<psize>>;
+
+// walks the parent moves back from last, steps are ordered from last to initial
+template <uint32_t psize, typename Queue>
+std::vector<permut_t<psize>> solution_steps(const Queue& queue, node_index last, permut_t<psize> initial) {
+    std::vector<permut_t<psize>> steps;
+    permut_t<psize> current = queue.node(last).permut;
+    while (current != initial) {
+        steps.push_back(current);
+        current = permut_undo_move<psize>(current, queue.node(last).parent_move);
+        last = queue.find(current);
+    }
+    steps.push_back(initial);
+    return steps;
+}
+
+// moves from the initial board to the goal for steps ordered like solution_steps
+template <uint32_t psize>
+std::vector<move_dir> solution_moves(const std::vector<permut_t<psize>>& steps) {
+    std::vector<move_dir> moves;
+    for (size_t i = steps.size() - 1; i > 0; --i) {
+        moves.push_back(permut_move_between<psize>(steps[i], steps[i - 1]));
+    }
+    return moves;
+}
+
+// the boards moves pass through from initial, ordered like solution_steps
+template <uint32_t psize>
+std::vector<permut_t<psize>> moves_steps(permut_t<psize> initial, const std::vector<move_dir>& moves) {
+    std::vector<permut_t<psize>> steps = {initial};
+    for (move_dir dir : moves) {
+        steps.push_back(permut_apply_move<psize>(steps.back(), dir));
+    }
+    std::reverse(steps.begin(), steps.end());
+    return steps;
+}
+
+template <uint32_t psize, typename Heuristic, typename Queue>
+std::optional<solution_t<psize>> find_solution(permut_t<psize> initial, Heuristic heuristic_dist, Queue& queue) {
+    constexpr permut_t<psize> goal = permut_goal<psize>;
     size_t processed = 0;
-    puzzle_queue queue;
-    queue.push(initial, queue.map_end(), 0, heuristic_dist(initial));
+    queue.clear();
+    queue.push(initial, permut_blank<psize>(initial), move_none, 0, heuristic_dist(initial));
     while (!queue.empty()) {
-        map_iterator current = queue.top();
-        if (current->first == goal) {
-            std::vector<permut_type> steps;
-            while (current->first != initial) {
-                steps.push_back(current->first);
-                current = current->second.parent;
-            }
-            steps.push_back(initial);
-            return solution{queue.map_size(), processed, std::move(steps)};
+        const node_index current = queue.top();
+        const auto& current_entry = queue.node(current);
+        if (current_entry.permut == goal) {
+            return solution_t<psize>{queue.map_size(), processed, solution_steps<psize>(queue, current, initial), queue.stats().counters()};
         }
         ++processed;
+        queue.stats().expanded(current_entry.dist_to + current_entry.dist_h, processed, queue.map_size());
         queue.pop();
-        permut_neighbors_itr<psize> neighbours(current->first);
-        for (permut_type n : neighbours) {
-            const uint32_t dist_new = current->second.dist_to + 1;
-            map_iterator n_map_itr = queue.find(n);
-            if (n_map_itr == queue.map_end()) {
-                queue.push(n, current, dist_new, heuristic_dist(n));
+        permut_moves_itr<psize> neighbours(current_entry.permut, current_entry.blank, current_entry.parent_move);
+        for (auto& n : neighbours) {
+            const uint32_t dist_new = current_entry.dist_to + 1;
+            const node_index n_index = queue.find(n.permut);
+            if (n_index == queue.map_end()) {
+                queue.push(n.permut, n.blank, n.dir, dist_new, queue.stats().heuristic([&] {
+                    return heuristic_update(heuristic_dist, current_entry.permut, n.permut, current_entry.dist_h);
+                }));
             } else {
-                if (dist_new < n_map_itr->second.dist_to) {
-                    queue.decrease_key(n_map_itr, current, dist_new);
+                if (dist_new < queue.node(n_index).dist_to) {
+                    queue.decrease_key(n_index, n.dir, dist_new);
                 }
             }
         }
@@ -163,40 +402,38 @@ std::optional<solution> find_solution(permut_type initial, Heuristic heuristic_d
     return std::nullopt;
 }
 
-template <uint32_t psize>
-std::optional<solution> find_solution_manhattan(permut_type initial) {
-    constexpr auto create_goal = []() -> permut_type {
-        if constexpr (psize == 3) {
-            return permut_create<psize>({0, 1, 2, 3, 4, 5, 6, 7, 8});
-        }
-        return permut_create<psize>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15});
-    };
-    constexpr permut_type goal = create_goal();
+template <uint32_t psize, typename Heuristic, typename Queue = puzzle_queue_t<psize>>
+std::optional<solution_t<psize>> find_solution(permut_t<psize> initial, Heuristic heuristic_dist) {
+    Queue queue;
+    return find_solution<psize>(initial, heuristic_dist, queue);
+}
+
+template <uint32_t psize, typename Queue>
+std::optional<solution_t<psize>> find_solution_manhattan(permut_t<psize> initial, Queue& queue) {
+    constexpr permut_t<psize> goal = permut_goal<psize>;
     size_t processed = 0;
-    puzzle_queue queue;
-    queue.push(initial, queue.map_end(), 0, manhattan_dist<psize>(initial));
+    queue.clear();
+    queue.push(initial, permut_blank<psize>(initial), move_none, 0, manhattan_dist<psize>(initial));
     while (!queue.empty()) {
-        map_iterator current = queue.top();
-        if (current->first == goal) {
-            std::vector<permut_type> steps;
-            while (current->first != initial) {
-                steps.push_back(current->first);
-                current = current->second.parent;
-            }
-            steps.push_back(initial);
-            return solution{queue.map_size(), processed, std::move(steps)};
+        const node_index current = queue.top();
+        const auto& current_entry = queue.node(current);
+        if (current_entry.permut == goal) {
+            return solution_t<psize>{queue.map_size(), processed, solution_steps<psize>(queue, current, initial), queue.stats().counters()};
         }
         ++processed;
+        queue.stats().expanded(current_entry.dist_to + current_entry.dist_h, processed, queue.map_size());
         queue.pop();
-        permut_neighbors_itr_winfo<psize> neighbours(current->first);
+        permut_moves_itr<psize> neighbours(current_entry.permut, current_entry.blank, current_entry.parent_move);
         for (auto& n : neighbours) {
-            const uint32_t dist_new = current->second.dist_to + 1;
-            map_iterator n_map_itr = queue.find(n.first);
-            if (n_map_itr == queue.map_end()) {
-                queue.push(n.first, current, dist_new, manhattan_dist_winfo<psize>(current->second.dist_h, n.second));
+            const uint32_t dist_new = current_entry.dist_to + 1;
+            const node_index n_index = queue.find(n.permut);
+            if (n_index == queue.map_end()) {
+                queue.push(n.permut, n.blank, n.dir, dist_new, queue.stats().heuristic([&] {
+                    return manhattan_dist_winfo<psize>(current_entry.dist_h, n.info);
+                }));
             } else {
-                if (dist_new < n_map_itr->second.dist_to) {
-                    queue.decrease_key(n_map_itr, current, dist_new);
+                if (dist_new < queue.node(n_index).dist_to) {
+                    queue.decrease_key(n_index, n.dir, dist_new);
                 }
             }
         }
@@ -204,41 +441,52 @@ std::optional<solution> find_solution_manhattan(permut_type initial) {
     return std::nullopt;
 }
 
-template <uint32_t psize, typename Heuristic>
-std::optional<solution> find_solution_manhattan_wadditional(permut_type initial, Heuristic additional) {
-    constexpr auto create_goal = []() -> permut_type {
-        if constexpr (psize == 3) {
-            return permut_create<psize>({0, 1, 2, 3, 4, 5, 6, 7, 8});
-        }
-        return permut_create<psize>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15});
-    };
-    constexpr permut_type goal = create_goal();
+template <uint32_t psize, typename Queue = puzzle_queue_t<psize>>
+std::optional<solution_t<psize>> find_solution_manhattan(permut_t<psize> initial) {
+    Queue queue;
+    return find_solution_manhattan<psize>(initial, queue);
+}
+
+// expansion check of a search that runs until it is done
+struct no_expansion_limit {
+    template <typename Entry>
+    constexpr bool operator()(const Entry&, size_t) const noexcept {
+        return false;
+    }
+};
+
+// stop_expanding sees the top of the open list and the expansions so far before every expansion, the search gives up when it returns true
+template <uint32_t psize, typename Heuristic, typename Queue, typename Limit = no_expansion_limit>
+std::optional<solution_t<psize>> find_solution_manhattan_wadditional(permut_t<psize> initial, Heuristic additional, Queue& queue, Limit stop_expanding = {}) {
+    constexpr permut_t<psize> goal = permut_goal<psize>;
     size_t processed = 0;
-    puzzle_queue queue;
-    queue.push(initial, queue.map_end(), 0, manhattan_dist<psize>(initial) + additional(initial));
+    queue.clear();
+    queue.push(initial, permut_blank<psize>(initial), move_none, 0, manhattan_dist<psize>(initial) + additional(initial));
     while (!queue.empty()) {
-        map_iterator current = queue.top();
-        if (current->first == goal) {
-            std::vector<permut_type> steps;
-            while (current->first != initial) {
-                steps.push_back(current->first);
-                current = current->second.parent;
-            }
-            steps.push_back(initial);
-            return solution{queue.map_size(), processed, std::move(steps)};
+        const node_index current = queue.top();
+        const auto& current_entry = queue.node(current);
+        if (current_entry.permut == goal) {
+            return solution_t<psize>{queue.map_size(), processed, solution_steps<psize>(queue, current, initial), queue.stats().counters()};
+        }
+        if (stop_expanding(current_entry, processed)) {
+            return std::nullopt;
         }
         ++processed;
+        queue.stats().expanded(current_entry.dist_to + current_entry.dist_h, processed, queue.map_size());
         queue.pop();
-        permut_neighbors_itr_winfo<psize> neighbours(current->first);
-        dist_type mdist = manhattan_dist<psize>(current->first);
+        permut_moves_itr<psize> neighbours(current_entry.permut, current_entry.blank, current_entry.parent_move);
+        dist_type mdist = manhattan_dist<psize>(current_entry.permut);
+        const dist_type additional_dist = current_entry.dist_h - mdist;
         for (auto& n : neighbours) {
-            const uint32_t dist_new = current->second.dist_to + 1;
-            map_iterator n_map_itr = queue.find(n.first);
-            if (n_map_itr == queue.map_end()) {
-                queue.push(n.first, current, dist_new, manhattan_dist_winfo<psize>(mdist, n.second) + additional(n.first));
+            const uint32_t dist_new = current_entry.dist_to + 1;
+            const node_index n_index = queue.find(n.permut);
+            if (n_index == queue.map_end()) {
+                queue.push(n.permut, n.blank, n.dir, dist_new, queue.stats().heuristic([&] {
+                    return manhattan_dist_winfo<psize>(mdist, n.info) + heuristic_update(additional, current_entry.permut, n.permut, additional_dist);
+                }));
             } else {
-                if (dist_new < n_map_itr->second.dist_to) {
-                    queue.decrease_key(n_map_itr, current, dist_new);
+                if (dist_new < queue.node(n_index).dist_to) {
+                    queue.decrease_key(n_index, n.dir, dist_new);
                 }
             }
         }
@@ -246,4 +494,127 @@ std::optional<solution> find_solution_manhattan_wadditional(permut_type initial,
     return std::nullopt;
 }
 
+template <uint32_t psize, typename Heuristic, typename Queue = puzzle_queue_t<psize>>
+std::optional<solution_t<psize>> find_solution_manhattan_wadditional(permut_t<psize> initial, Heuristic additional) {
+    Queue queue;
+    return find_solution_manhattan_wadditional<psize>(initial, additional, queue);
+}
+
+// EPEA*: an expansion stores only the children whose f equals the f of the node, the node then goes back to the open list with the next
+// larger child f, so children above the optimal cost are never stored; dist_h of a partially expanded node holds that f minus g
+template <uint32_t psize, typename Heuristic, typename Queue>
+std::optional<solution_t<psize>> find_solution_epea(permut_t<psize> initial, Heuristic additional, Queue& queue) {
+    constexpr permut_t<psize> goal = permut_goal<psize>;
+    constexpr uint32_t no_next = std::numeric_limits<uint32_t>::max();
+    size_t processed = 0;
+    queue.clear();
+    queue.push(initial, permut_blank<psize>(initial), move_none, 0, manhattan_dist<psize>(initial) + additional(initial));
+    while (!queue.empty()) {
+        const node_index current = queue.top();
+        const auto& current_entry = queue.node(current);
+        if (current_entry.permut == goal) {
+            return solution_t<psize>{queue.map_size(), processed, solution_steps<psize>(queue, current, initial), queue.stats().counters()};
+        }
+        const uint32_t dist_f = current_entry.dist_to + current_entry.dist_h;
+        ++processed;
+        queue.stats().expanded(dist_f, processed, queue.map_size());
+        queue.pop();
+        const dist_type mdist = manhattan_dist<psize>(current_entry.permut);
+        const dist_type additional_dist = additional(current_entry.permut);
+        // the first expansion also takes children below f, a heuristic that is not consistent has them
+        const bool first = dist_f == static_cast<uint32_t>(current_entry.dist_to + mdist + additional_dist);
+        const uint32_t dist_new = current_entry.dist_to + 1;
+        uint32_t next_f = no_next;
+        permut_moves_itr<psize> neighbours(current_entry.permut, current_entry.blank, current_entry.parent_move);
+        for (auto& n : neighbours) {
+            const dist_type dist_h = queue.stats().heuristic([&] {
+                return manhattan_dist_winfo<psize>(mdist, n.info) + heuristic_update(additional, current_entry.permut, n.permut, additional_dist);
+            });
+            const uint32_t n_dist_f = dist_new + dist_h;
+            if (n_dist_f > dist_f) {
+                next_f = std::min(next_f, n_dist_f);
+                continue;
+            }
+            if (n_dist_f < dist_f && !first) {
+                continue;
+            }
+            const node_index n_index = queue.find(n.permut);
+            if (n_index == queue.map_end()) {
+                queue.push(n.permut, n.blank, n.dir, dist_new, dist_h);
+            } else if (dist_new < queue.node(n_index).dist_to) {
+                // a shorter path starts its expansions over
+                queue.decrease_key(n_index, n.dir, dist_new, dist_h);
+            }
+        }
+        if (next_f != no_next) {
+            queue.decrease_key(current, current_entry.parent_move, current_entry.dist_to, next_f - current_entry.dist_to);
+        }
+    }
+    return std::nullopt;
+}
+
+template <uint32_t psize, typename Heuristic, typename Queue = puzzle_queue_t<psize>>
+std::optional<solution_t<psize>> find_solution_epea(permut_t<psize> initial, Heuristic additional) {
+    Queue queue;
+    return find_solution_epea<psize>(initial, additional, queue);
+}
+
+template <uint32_t psize, typename Heuristic>
+struct ida_state {
+    permut_t<psize> goal;
+    Heuristic& additional;
+    std::vector<permut_t<psize>> path;
+    size_t touched;
+    size_t processed;
+    uint32_t next_bound;
+    [[no_unique_address]] search_stats stats;
+};
+
+template <uint32_t psize, typename Heuristic>
+bool ida_search(ida_state<psize, Heuristic>& state, uint32_t blank, move_dir previous, uint32_t dist_to, dist_type mdist, dist_type additional_dist, uint32_t bound) {
+    const permut_t<psize> current = state.path.back();
+    if (current == state.goal) {
+        return true;
+    }
+    ++state.processed;
+    state.stats.expanded(bound, state.processed, state.touched);
+    // never undo the move that led here
+    permut_moves_itr<psize> neighbours(current, blank, previous);
+    for (auto& n : neighbours) {
+        ++state.touched;
+        const dist_type n_mdist = manhattan_dist_winfo<psize>(mdist, n.info);
+        const dist_type n_additional_dist = state.stats.heuristic([&] {
+            return heuristic_update(state.additional, current, n.permut, additional_dist);
+        });
+        const uint32_t dist_f = dist_to + 1 + n_mdist + n_additional_dist;
+        if (dist_f > bound) {
+            state.next_bound = std::min(state.next_bound, dist_f);
+            continue;
+        }
+        state.path.push_back(n.permut);
+        if (ida_search(state, n.blank, n.dir, dist_to + 1, n_mdist, n_additional_dist, bound)) {
+            return true;
+        }
+        state.path.pop_back();
+    }
+    return false;
+}
+
+template <uint32_t psize, typename Heuristic>
+std::optional<solution_t<psize>> find_solution_ida(permut_t<psize> initial, Heuristic additional) {
+    constexpr uint32_t no_bound = std::numeric_limits<uint32_t>::max();
+    ida_state<psize, Heuristic> state{permut_goal<psize>, additional, {initial}, 1, 0, no_bound, {}};
+    const dist_type mdist = manhattan_dist<psize>(initial);
+    const dist_type additional_dist = additional(initial);
+    uint32_t bound = mdist + additional_dist;
+    while (bound != no_bound) {
+        state.next_bound = no_bound;
+        if (ida_search(state, permut_blank<psize>(initial), move_none, 0, mdist, additional_dist, bound)) {
+            return solution_t<psize>{state.touched, state.processed, {state.path.rbegin(), state.path.rend()}, state.stats.counters()};
+        }
+        bound = state.next_bound;
+    }
+    return std::nullopt;
+}
+
 }  // namespace puzzle
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+// build with -DPUZZLE_STATS=1 to collect search statistics, without it every hook is an empty inline function
+#ifndef PUZZLE_STATS
+#define PUZZLE_STATS 0
+#endif
+
+namespace puzzle {
+
+struct search_progress {
+    size_t processed;
+    size_t touched;
+    double seconds;
+    double nodes_per_s;
+    uint32_t f_bound;
+};
+
+using progress_callback = std::function<void(const search_progress&)>;
+
+template <bool enabled>
+struct basic_search_counters;
+
+template <>
+struct basic_search_counters<false> {
+    std::ostream& write_json(std::ostream& stream) const {
+        return stream << "{\"enabled\":false}";
+    }
+};
+
+template <>
+struct basic_search_counters<true> {
+    uint64_t sift_steps = 0;
+    uint64_t map_lookups = 0;
+    uint64_t map_hits = 0;
+    uint64_t decrease_keys = 0;
+    uint64_t reopenings = 0;
+    uint64_t heuristic_evals = 0;
+    uint64_t heuristic_ns = 0;
+    // expanded nodes per f value
+    std::vector<uint64_t> f_histogram;
+
+    std::ostream& write_json(std::ostream& stream) const {
+        stream << "{\"enabled\":true,\"sift_steps\":" << sift_steps << ",\"map_lookups\":" << map_lookups << ",\"map_hits\":" << map_hits
+               << ",\"decrease_keys\":" << decrease_keys << ",\"reopenings\":" << reopenings << ",\"heuristic_evals\":" << heuristic_evals
+               << ",\"heuristic_ns\":" << heuristic_ns << ",\"f_histogram\":{";
+        bool first = true;
+        for (size_t f = 0; f < f_histogram.size(); ++f) {
+            if (f_histogram[f] != 0) {
+                stream << (first ? "" : ",") << '"' << f << "\":" << f_histogram[f];
+                first = false;
+            }
+        }
+        return stream << "}}";
+    }
+};
+
+template <bool enabled>
+class basic_search_stats;
+
+template <>
+class basic_search_stats<false> {
+public:
+    void on_progress(progress_callback, double = 1.0) {}
+    void reset() {}
+    void sift_step() {}
+    void lookup(bool) {}
+    void decrease_key(bool) {}
+    template <typename F>
+    auto heuristic(F&& evaluate) {
+        return evaluate();
+    }
+    void expanded(uint32_t, size_t, size_t) {}
+    basic_search_counters<false> counters() const {
+        return {};
+    }
+};
+
+template <>
+class basic_search_stats<true> {
+    using clock = std::chrono::steady_clock;
+    // the clock is only read every this many expansions
+    static constexpr size_t check_every = 4096;
+
+    basic_search_counters<true> data;
+    progress_callback callback;
+    double interval = 1.0;
+    clock::time_point start = clock::now();
+    clock::time_point last_report = start;
+    size_t since_check = 0;
+
+public:
+    void on_progress(progress_callback new_callback, double interval_seconds = 1.0) {
+        callback = std::move(new_callback);
+        interval = interval_seconds;
+    }
+    // keeps the callback
+    void reset() {
+        data = {};
+        start = clock::now();
+        last_report = start;
+        since_check = 0;
+    }
+    void sift_step() {
+        ++data.sift_steps;
+    }
+    void lookup(bool hit) {
+        ++data.map_lookups;
+        data.map_hits += hit;
+    }
+    void decrease_key(bool reopened) {
+        ++data.decrease_keys;
+        data.reopenings += reopened;
+    }
+    template <typename F>
+    auto heuristic(F&& evaluate) {
+        const auto eval_start = clock::now();
+        const auto value = evaluate();
+        data.heuristic_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - eval_start).count();
+        ++data.heuristic_evals;
+        return value;
+    }
+    void expanded(uint32_t f, size_t processed, size_t touched) {
+        if (f >= data.f_histogram.size()) {
+            data.f_histogram.resize(f + 1);
+        }
+        ++data.f_histogram[f];
+        if (!callback || ++since_check < check_every) {
+            return;
+        }
+        since_check = 0;
+        const auto now = clock::now();
+        if (std::chrono::duration<double>(now - last_report).count() >= interval) {
+            last_report = now;
+            const double seconds = std::chrono::duration<double>(now - start).count();
+            callback(search_progress{processed, touched, seconds, processed / seconds, f});
+        }
+    }
+    const basic_search_counters<true>& counters() const {
+        return data;
+    }
+};
+
+using search_counters = basic_search_counters<PUZZLE_STATS != 0>;
+using search_stats = basic_search_stats<PUZZLE_STATS != 0>;
+
+}  // namespace puzzle
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace puzzle {
+
+// every worker owns a deque, it takes its own newest task first and steals the oldest task of another worker when idle
+class thread_pool {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+    struct worker_queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<size_t> pending = 0;
+    std::atomic<size_t> next_queue = 0;
+    bool stopping = false;
+
+    static inline thread_local size_t current_worker = npos;
+    static inline thread_local const thread_pool* current_pool = nullptr;
+
+    bool try_pop(size_t own, std::function<void()>& task) {
+        {
+            worker_queue& q = *queues[own];
+            std::lock_guard lock(q.mutex);
+            if (!q.tasks.empty()) {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t i = 1; i < queues.size(); ++i) {
+            worker_queue& q = *queues[(own + i) % queues.size()];
+            std::lock_guard lock(q.mutex);
+            if (!q.tasks.empty()) {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+    void run(size_t own) {
+        current_worker = own;
+        current_pool = this;
+        std::function<void()> task;
+        while (true) {
+            if (try_pop(own, task)) {
+                --pending;
+                task();
+                continue;
+            }
+            std::unique_lock lock(sleep_mutex);
+            wake.wait(lock, [this] { return stopping || pending > 0; });
+            if (stopping && pending == 0) {
+                return;
+            }
+        }
+    }
+    void enqueue(std::function<void()> task) {
+        // tasks submitted from a worker stay local, the rest are spread round robin
+        const size_t target = current_pool == this ? current_worker : next_queue++ % queues.size();
+        {
+            std::lock_guard lock(queues[target]->mutex);
+            queues[target]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard lock(sleep_mutex);
+            ++pending;
+        }
+        wake.notify_one();
+    }
+
+public:
+    explicit thread_pool(size_t n_threads = std::thread::hardware_concurrency()) {
+        n_threads = std::max<size_t>(n_threads, 1);
+        for (size_t i = 0; i < n_threads; ++i) {
+            queues.push_back(std::make_unique<worker_queue>());
+        }
+        for (size_t i = 0; i < n_threads; ++i) {
+            threads.emplace_back(&thread_pool::run, this, i);
+        }
+    }
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // finishes every submitted task before joining
+    ~thread_pool() {
+        {
+            std::lock_guard lock(sleep_mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F f) {
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::move(f));
+        auto result = task->get_future();
+        enqueue([task] { (*task)(); });
+        return result;
+    }
+
+    size_t size() const noexcept {
+        return threads.size();
+    }
+
+    // index of the calling worker, for per-thread state kept outside the pool
+    static size_t worker_index() noexcept {
+        return current_worker;
+    }
+};
+
+}  // namespace puzzle
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+#include "15puzzle.h"
+
+namespace puzzle {
+
+// walking distance: the empty field carries the tiles between neighbouring rows until every row holds the tiles of its goal row, the
+// moves this takes at least are counted over only how many tiles of each goal row every row holds; columns are the same problem on the
+// transposed board, so rows and columns share one table
+template <uint32_t psize>
+struct walking_distance_tables {
+    static_assert(psize <= 4, "the line codes of bigger boards do not fit the tables");
+
+    static constexpr uint32_t radix = psize + 1;
+    static constexpr uint32_t power(uint32_t base, uint32_t exp) {
+        uint32_t n = 1;
+        while (exp-- > 0) {
+            n *= base;
+        }
+        return n;
+    }
+    static constexpr uint32_t digit_sum(uint32_t code) {
+        uint32_t sum = 0;
+        for (; code != 0; code /= radix) {
+            sum += code % radix;
+        }
+        return sum;
+    }
+    // a line code has the number of the line's tiles that belong to goal line g as digit g, the code of two lines is their sum
+    static constexpr uint32_t n_codes = power(radix, psize);
+    // codes of a full line and of the line with the empty field
+    static constexpr uint32_t n_contents = [] {
+        uint32_t n = 0;
+        for (uint32_t code = 0; code < n_codes; ++code) {
+            n += digit_sum(code) + 1 >= psize && digit_sum(code) <= psize;
+        }
+        return n;
+    }();
+    // a state is the contents of every line but the last one, which the others leave no choice for
+    static constexpr uint32_t n_states = power(n_contents, psize - 1);
+    static constexpr uint8_t unreached = 0xff;
+
+    // [tile] -> radix to the power of its goal row or column, 0 for the empty tile
+    std::array<uint16_t, psize * psize> row_digit{};
+    std::array<uint16_t, psize * psize> col_digit{};
+    // the same for two neighbouring fields at once, [tile of the first << 4 | tile of the second]
+    std::array<uint16_t, 256> row_pair{};
+    std::array<uint16_t, 256> col_pair{};
+    // [line][code] -> the line's share of the state index
+    std::array<std::array<uint32_t, n_codes>, psize> line_index{};
+    std::array<uint8_t, n_states> distance{};
+
+    walking_distance_tables() {
+        constexpr uint32_t empty = psize * psize - 1;
+        for (uint32_t tile = 0; tile < empty; ++tile) {
+            row_digit[tile] = power(radix, tile / psize);
+            col_digit[tile] = power(radix, tile % psize);
+        }
+        for (uint32_t tiles = 0; tiles < 256; ++tiles) {
+            const uint32_t first = tiles >> 4;
+            const uint32_t second = tiles & 0xf;
+            if (first < psize * psize && second < psize * psize) {
+                row_pair[tiles] = row_digit[first] + row_digit[second];
+                col_pair[tiles] = col_digit[first] + col_digit[second];
+            }
+        }
+        uint32_t content = 0;
+        for (uint32_t code = 0; code < n_codes; ++code) {
+            if (digit_sum(code) + 1 >= psize && digit_sum(code) <= psize) {
+                for (uint32_t line = 0; line + 1 < psize; ++line) {
+                    line_index[line][code] = content * power(n_contents, psize - 2 - line);
+                }
+                ++content;
+            }
+        }
+        // breadth first from the goal, the moves are their own inverse; codes[line] is the code of a line
+        std::array<uint32_t, psize> goal{};
+        for (uint32_t line = 0; line < psize; ++line) {
+            goal[line] = (line + 1 < psize ? psize : psize - 1) * power(radix, line);
+        }
+        auto state_index = [this](const std::array<uint32_t, psize>& codes) {
+            uint32_t index = 0;
+            for (uint32_t line = 0; line + 1 < psize; ++line) {
+                index += line_index[line][codes[line]];
+            }
+            return index;
+        };
+        std::vector<std::array<uint32_t, psize>> open{goal};
+        distance.fill(unreached);
+        distance[state_index(goal)] = 0;
+        for (size_t next = 0; next < open.size(); ++next) {
+            const std::array<uint32_t, psize> codes = open[next];
+            const uint8_t dist = distance[state_index(codes)];
+            uint32_t blank = 0;
+            while (digit_sum(codes[blank]) == psize) {
+                ++blank;
+            }
+            for (uint32_t from : {blank - 1, blank + 1}) {
+                if (from >= psize) {
+                    continue;
+                }
+                for (uint32_t goal_line = 0; goal_line < psize; ++goal_line) {
+                    const uint32_t digit = power(radix, goal_line);
+                    if (codes[from] / digit % radix == 0) {
+                        continue;
+                    }
+                    std::array<uint32_t, psize> moved = codes;
+                    moved[from] -= digit;
+                    moved[blank] += digit;
+                    uint8_t& moved_dist = distance[state_index(moved)];
+                    if (moved_dist == unreached) {
+                        moved_dist = dist + 1;
+                        open.push_back(moved);
+                    }
+                }
+            }
+        }
+    }
+
+    uint32_t row_code(permut_t<psize> a, uint32_t row) const {
+        constexpr int offset = std::bit_width(psize * psize - 1);
+        constexpr permut_t<psize> mask = ~(~0U << offset);
+        if constexpr (psize == 4) {
+            const uint32_t line = (a >> ((psize - 1 - row) * 16)) & 0xffff;
+            return row_pair[line >> 8] + row_pair[line & 0xff];
+        }
+        uint32_t code = 0;
+        for (uint32_t field = row * psize; field < (row + 1) * psize; ++field) {
+            code += row_digit[static_cast<uint32_t>(a >> ((psize * psize - 1 - field) * offset)) & mask];
+        }
+        return code;
+    }
+    uint32_t col_code(permut_t<psize> a, uint32_t col) const {
+        constexpr int offset = std::bit_width(psize * psize - 1);
+        constexpr permut_t<psize> mask = ~(~0U << offset);
+        if constexpr (psize == 4) {
+            // folded as in col_conflict
+            permut_t<psize> line = (a >> ((psize - 1 - col) * 4)) & 0x000f000f000f000fULL;
+            line |= line >> 12;
+            return col_pair[(line >> 32) & 0xff] + col_pair[line & 0xff];
+        }
+        uint32_t code = 0;
+        for (uint32_t field = col; field < psize * psize; field += psize) {
+            code += col_digit[static_cast<uint32_t>(a >> ((psize * psize - 1 - field) * offset)) & mask];
+        }
+        return code;
+    }
+    uint32_t row_index(permut_t<psize> a) const {
+        uint32_t index = 0;
+        for (uint32_t row = 0; row + 1 < psize; ++row) {
+            index += line_index[row][row_code(a, row)];
+        }
+        return index;
+    }
+    uint32_t col_index(permut_t<psize> a) const {
+        uint32_t index = 0;
+        for (uint32_t col = 0; col + 1 < psize; ++col) {
+            index += line_index[col][col_code(a, col)];
+        }
+        return index;
+    }
+};
+
+// the breadth first search is too long for a constant expression, the tables are built on first use instead
+template <uint32_t psize>
+const walking_distance_tables<psize>& wd_tables() {
+    static const walking_distance_tables<psize> tables;
+    return tables;
+}
+
+template <uint32_t psize>
+dist_type walking_distance(const walking_distance_tables<psize>& tables, permut_t<psize> a) {
+    return tables.distance[tables.row_index(a)] + tables.distance[tables.col_index(a)];
+}
+
+template <uint32_t psize>
+dist_type walking_distance(permut_t<psize> a) {
+    return walking_distance<psize>(wd_tables<psize>(), a);
+}
+
+// walking_distance as the whole heuristic of find_solution, it is never below manhattan_dist; there is no update, working a move out
+// from the lines it changes needs the index of the old board, which costs as much as the new board's
+template <uint32_t psize>
+struct walking_distance_heuristic {
+    const walking_distance_tables<psize>* tables = &wd_tables<psize>();
+
+    dist_type operator()(permut_t<psize> a) const {
+        return walking_distance<psize>(*tables, a);
+    }
+};
+
+// the larger of walking_distance and manhattan_dist_wlc, they count some of the same moves so they cannot be added; the maximum does not
+// say which of the two it came from, so it is recomputed for every board
+template <uint32_t psize>
+struct walking_distance_wlc_heuristic {
+    const walking_distance_tables<psize>* tables = &wd_tables<psize>();
+
+    dist_type operator()(permut_t<psize> a) const {
+        return std::max(walking_distance<psize>(*tables, a), manhattan_dist_wlc<psize>(a));
+    }
+};
+
+}  // namespace puzzle
@@ -1,9 +1,26 @@
 #include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <random>
 #include <stdexcept>
+#include <string_view>
 
+#include "15puzzle_anytime.h"
+#include "15puzzle_async.h"
+#include "15puzzle_cache.h"
+#include "15puzzle_generator.h"
+#include "15puzzle_hda.h"
+#include "15puzzle_io.h"
+#include "15puzzle_memory_bounded.h"
+#include "15puzzle_pdb.h"
 #include "15puzzle_solver.h"
+#include "15puzzle_thread_pool.h"
+#include "15puzzle_walking_distance.h"
 
 #define PUZZLE_SIZE 4
 
@@ -11,9 +28,10 @@ enum print_mode {
     basic = 0,
     w_initial = 1,
     w_steps = (w_initial << 1),
+    w_moves = (w_steps << 1),
 };
 
-void solution_print(std::ostream& stream, const puzzle::solution& sol, int mode = print_mode::basic) {
+void solution_print(std::ostream& stream, const puzzle::solution_t<PUZZLE_SIZE>& sol, int mode = print_mode::basic) {
     stream << sol.processed << ' ' << sol.touched << ' ' << sol.steps.size() << "\n";
     if (mode & print_mode::w_initial) {
         puzzle::permut_write<PUZZLE_SIZE>(stream, sol.steps.back()) << "...\n";
@@ -25,34 +43,360 @@ void solution_print(std::ostream& stream, const puzzle::solution& sol, int mode
             ++it;
         }
     }
+    if (mode & print_mode::w_moves) {
+        stream << puzzle::moves_text(puzzle::solution_moves<PUZZLE_SIZE>(sol.steps)) << '\n';
+    }
+}
+
+int pdb_generate(std::string_view partition_name, const std::string& path) {
+    if (partition_name != "663" && partition_name != "78") {
+        std::cerr << "unknown partition " << partition_name << ", use 663 or 78\n";
+        return 1;
+    }
+    const auto& partition = partition_name == "663" ? puzzle::pdb_partition_663 : puzzle::pdb_partition_78;
+    puzzle::pattern_database<PUZZLE_SIZE>::generate(partition).save(path);
+    return 0;
 }
 
-puzzle::permut_type get_random_permut(std::mt19937& src_of_randomnes) {
-    constexpr auto create_initial_permut = []() -> auto{
-        if constexpr (PUZZLE_SIZE == 3) {
-            return std::array{0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U};
+enum class batch_output {
+    // id processed touched steps
+    text,
+    // the same followed by the move letters
+    moves,
+    // moves_write_binary records without ids
+    binary,
+};
+
+// instances from a text stream, a binary stream or a mapped binary file
+struct batch_input {
+    std::istream* stream = nullptr;
+    const puzzle::instance_file<PUZZLE_SIZE>* file = nullptr;
+    bool binary = false;
+    size_t next = 0;
+
+    // 0 at the end or on an invalid instance, complete tells them apart
+    puzzle::permut_t<PUZZLE_SIZE> read() {
+        if (file != nullptr) {
+            const puzzle::permut_t<PUZZLE_SIZE> permut = next < file->size() ? (*file)[next] : 0;
+            next += permut != 0;
+            return permut;
+        }
+        return binary ? puzzle::permut_read_binary<PUZZLE_SIZE>(*stream) : puzzle::permut_read<PUZZLE_SIZE>(*stream);
+    }
+    bool complete() const {
+        return file != nullptr ? next == file->size() : stream->eof();
+    }
+};
+
+// per instance, the clock starts when the instance is handed to the pool
+struct batch_limits {
+    std::chrono::steady_clock::duration time_budget = std::chrono::steady_clock::duration::max();
+    size_t node_budget = std::numeric_limits<size_t>::max();
+};
+
+// results come out in input order, each text line is prefixed with the instance number; the cache is only touched on this thread
+int solve_batch(batch_input& input, batch_output output, const batch_limits& limits, puzzle::solution_cache<PUZZLE_SIZE>* cache = nullptr) {
+    puzzle::thread_pool pool;
+    puzzle::async_solver<PUZZLE_SIZE> solver(pool);
+    std::deque<std::future<puzzle::solve_result<PUZZLE_SIZE>>> in_flight;
+    const size_t max_in_flight = 4 * pool.size();
+    size_t n_read = 0;
+    size_t n_printed = 0;
+    auto print_oldest = [&]() {
+        const auto result = in_flight.front().get();
+        in_flight.pop_front();
+        const auto& sol = result.solution;
+        std::optional<std::vector<puzzle::move_dir>> moves;
+        if (sol.has_value()) {
+            moves = puzzle::solution_moves<PUZZLE_SIZE>(sol->steps);
+            if (cache != nullptr) {
+                cache->insert(sol->steps.back(), *moves);
+            }
+        }
+        if (output == batch_output::binary) {
+            puzzle::moves_write_binary(std::cout, moves);
+            return;
+        }
+        std::cout << n_printed++ << ' ';
+        if (result.status == puzzle::solve_status::unsolvable) {
+            std::cout << "no solution\n";
+        } else if (!sol.has_value()) {
+            std::cout << puzzle::solve_status_name(result.status) << ' ' << result.processed << ' ' << result.touched << ' ' << result.lower_bound << '\n';
+        } else if (output == batch_output::moves) {
+            std::cout << sol->processed << ' ' << sol->touched << ' ' << sol->steps.size() << ' ' << puzzle::moves_text(*moves) << '\n';
         } else {
-            return std::array{0U, 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 9U, 10U, 11U, 12U, 13U, 14U};
+            solution_print(std::cout, *sol);
         }
     };
-    constexpr auto initial_permut = create_initial_permut();
-    std::array temp_partial_arr{initial_permut};
-    do {
-        std::shuffle(temp_partial_arr.begin(), temp_partial_arr.end(), src_of_randomnes);
-    } while (!puzzle::parity_check<PUZZLE_SIZE * PUZZLE_SIZE - 1>(temp_partial_arr));
-    return puzzle::permut_create_from_partial<PUZZLE_SIZE>(temp_partial_arr);
+    const auto start = std::chrono::steady_clock::now();
+    while (true) {
+        const puzzle::permut_t<PUZZLE_SIZE> permut = input.read();
+        if (permut == 0) {
+            break;
+        }
+        if (in_flight.size() == max_in_flight) {
+            print_oldest();
+        }
+        if (cache != nullptr) {
+            if (const auto moves = cache->find(permut)) {
+                std::promise<puzzle::solve_result<PUZZLE_SIZE>> cached;
+                const uint32_t n_moves = moves->size();
+                cached.set_value({puzzle::solve_status::solved, puzzle::solution_t<PUZZLE_SIZE>{0, 0, puzzle::moves_steps<PUZZLE_SIZE>(permut, *moves)}, 0, 0, n_moves});
+                in_flight.push_back(cached.get_future());
+                ++n_read;
+                continue;
+            }
+        }
+        puzzle::solve_limits solve_limits;
+        solve_limits.node_budget = limits.node_budget;
+        solve_limits.time_budget = limits.time_budget;
+        in_flight.push_back(solver.submit(permut, solve_limits));
+        ++n_read;
+    }
+    while (!in_flight.empty()) {
+        print_oldest();
+    }
+    std::cout.flush();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << n_read << " instances in " << seconds << " s, " << n_read / seconds << " instances/s on " << pool.size() << " threads\n";
+    if (cache != nullptr) {
+        std::cerr << cache->hits() << " cache hits, " << cache->size() << " boards cached\n";
+    }
+    if (!input.complete()) {
+        std::cerr << "invalid instance " << n_read << '\n';
+        return 1;
+    }
+    return 0;
+}
+
+// text instances in, binary instances out
+int to_binary(std::istream& input) {
+    size_t n_written = 0;
+    while (true) {
+        const puzzle::permut_t<PUZZLE_SIZE> permut = puzzle::permut_read<PUZZLE_SIZE>(input);
+        if (permut == 0) {
+            break;
+        }
+        puzzle::permut_write_binary<PUZZLE_SIZE>(std::cout, permut);
+        ++n_written;
+    }
+    std::cout.flush();
+    if (!input.eof()) {
+        std::cerr << "invalid instance " << n_written << '\n';
+        return 1;
+    }
+    return 0;
 }
 
-int main() {
+// --generate COUNT [--seed N] [--min H] [--max H] [--text] [--buckets WIDTH PREFIX]
+int generate_main(int argc, char* argv[]) {
+    if (argc < 3 || std::string_view(argv[2]).starts_with("--")) {
+        std::cerr << "usage: " << argv[0] << " --generate COUNT [--seed N] [--min H] [--max H] [--text] [--buckets WIDTH PREFIX]\n";
+        return 1;
+    }
+    const size_t count = std::stoull(argv[2]);
+    puzzle::generator_options options;
+    bool seeded = false;
+    bool text = false;
+    uint32_t bucket_width = 0;
+    std::string prefix;
+    for (int i = 3; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::stoull(argv[++i]);
+            seeded = true;
+        } else if (arg == "--min" && i + 1 < argc) {
+            const auto min_estimate = puzzle::min_estimate_of<PUZZLE_SIZE>(std::stoul(argv[++i]));
+            if (!min_estimate) {
+                std::cerr << "--min is above " << +puzzle::max_solution_length<PUZZLE_SIZE> << ", no board needs that many moves\n";
+                return 1;
+            }
+            options.min_estimate = *min_estimate;
+        } else if (arg == "--max" && i + 1 < argc) {
+            options.max_estimate = std::min<unsigned long>(std::stoul(argv[++i]), std::numeric_limits<puzzle::dist_type>::max());
+        } else if (arg == "--text") {
+            text = true;
+        } else if (arg == "--buckets" && i + 2 < argc) {
+            bucket_width = std::max<unsigned long>(std::stoul(argv[++i]), 1);
+            prefix = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " --generate COUNT [--seed N] [--min H] [--max H] [--text] [--buckets WIDTH PREFIX]\n";
+            return 1;
+        }
+    }
+    if (options.min_estimate > options.max_estimate) {
+        std::cerr << "--min is above --max\n";
+        return 1;
+    }
+    if (!seeded) {
+        std::random_device random_device;
+        options.seed = (static_cast<uint64_t>(random_device()) << 32) | random_device();
+    }
+    std::cerr << "seed " << options.seed << '\n';
+    // bucket files are named PREFIX.LOW, LOW the smallest estimate they take
+    std::map<uint32_t, std::ofstream> buckets;
+    auto out = [&](puzzle::dist_type estimate) -> std::ostream& {
+        if (bucket_width == 0) {
+            return std::cout;
+        }
+        const uint32_t low = puzzle::estimate_bucket(estimate, bucket_width);
+        auto [bucket, created] = buckets.try_emplace(low);
+        if (created) {
+            const std::string path = prefix + '.' + std::to_string(low);
+            bucket->second.open(path, text ? std::ios::out : std::ios::out | std::ios::binary);
+            if (!bucket->second) {
+                throw std::runtime_error("cannot open " + path);
+            }
+        }
+        return bucket->second;
+    };
+#if PUZZLE_SIZE <= 4
+    const puzzle::walking_distance_wlc_heuristic<PUZZLE_SIZE> heuristic;
+#else
+    const auto heuristic = puzzle::manhattan_dist_wlc<PUZZLE_SIZE>;
+#endif
+    // only worked out when something looks at it
+    const bool estimated = bucket_width != 0 || options.min_estimate != 0 || options.max_estimate != std::numeric_limits<puzzle::dist_type>::max();
+    auto estimate = [&heuristic, estimated](puzzle::permut_t<PUZZLE_SIZE> permut) -> puzzle::dist_type {
+        return estimated ? heuristic(permut) : 0;
+    };
+    puzzle::thread_pool pool;
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        puzzle::generate_instances<PUZZLE_SIZE>(pool, count, options, estimate, [&](const puzzle::generated_instance<PUZZLE_SIZE>& instance) {
+            std::ostream& stream = out(instance.estimate);
+            if (text) {
+                puzzle::permut_write<PUZZLE_SIZE>(stream, instance.permut) << '\n';
+            } else {
+                puzzle::permut_write_binary<PUZZLE_SIZE>(stream, instance.permut);
+            }
+        });
+    } catch (const std::exception& e) {
+        std::cout.flush();
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    std::cout.flush();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << count << " instances in " << seconds << " s, " << count / seconds << " instances/s on " << pool.size() << " threads\n";
+    return 0;
+}
+
+// --batch [--binary | --mapped] [--moves | --binary-out] [--cache FILE] [--deadline SECONDS] [--budget NODES] [file]
+int batch_main(int argc, char* argv[]) {
+    bool binary_in = false;
+    bool mapped = false;
+    batch_output output = batch_output::text;
+    const char* cache_path = nullptr;
+    const char* path = nullptr;
+    batch_limits limits;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--binary") {
+            binary_in = true;
+        } else if (arg == "--mapped") {
+            mapped = true;
+        } else if (arg == "--moves") {
+            output = batch_output::moves;
+        } else if (arg == "--binary-out") {
+            output = batch_output::binary;
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_path = argv[++i];
+        } else if (arg == "--deadline" && i + 1 < argc) {
+            limits.time_budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(std::stod(argv[++i])));
+        } else if (arg == "--budget" && i + 1 < argc) {
+            limits.node_budget = std::stoull(argv[++i]);
+        } else if (path == nullptr && !arg.starts_with("--")) {
+            path = argv[i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " --batch [--binary | --mapped] [--moves | --binary-out] [--cache FILE] [--deadline SECONDS] [--budget NODES] [file]\n";
+            return 1;
+        }
+    }
+    if (mapped && path == nullptr) {
+        std::cerr << "--mapped needs a file\n";
+        return 1;
+    }
+    std::optional<puzzle::solution_cache<PUZZLE_SIZE>> cache;
+    if (cache_path != nullptr) {
+        cache.emplace(1 << 16, cache_path);
+    }
+    batch_input input;
+    input.binary = binary_in;
+    std::optional<puzzle::instance_file<PUZZLE_SIZE>> file;
+    std::ifstream stream;
+    if (mapped) {
+        file.emplace(path);
+        input.file = &*file;
+    } else if (path != nullptr) {
+        stream.open(path, binary_in ? std::ios::binary : std::ios::in);
+        if (!stream) {
+            std::cerr << "cannot open " << path << '\n';
+            return 1;
+        }
+        input.stream = &stream;
+    } else {
+        input.stream = &std::cin;
+    }
+    return solve_batch(input, output, limits, cache ? &*cache : nullptr);
+}
+
+int main(int argc, char* argv[]) {
+    const std::string_view mode = argc > 1 ? argv[1] : "";
+    if (mode == "--pdb-generate" && argc == 4) {
+        return pdb_generate(argv[2], argv[3]);
+    }
+    if (mode == "--batch") {
+        return batch_main(argc, argv);
+    }
+    if (mode == "--generate") {
+        return generate_main(argc, argv);
+    }
+    if (mode == "--to-binary" && argc == 2) {
+        return to_binary(std::cin);
+    }
     std::random_device random_device;
     std::mt19937 src_of_randomnes(random_device());
-    auto permut = get_random_permut(src_of_randomnes);
+    auto permut = puzzle::permut_random<PUZZLE_SIZE>(src_of_randomnes);
     puzzle::permut_write<PUZZLE_SIZE>(std::cout, permut) << '\n';
-    // auto sol = puzzle::find_solution_manhattan<PUZZLE_SIZE>(permut);
-    auto additional = puzzle::linear_conflict<PUZZLE_SIZE>;
-    auto sol = puzzle::find_solution_manhattan_wadditional<PUZZLE_SIZE, decltype(additional)>(permut, additional);
+    std::optional<puzzle::solution_t<PUZZLE_SIZE>> sol;
+    puzzle::puzzle_queue_t<PUZZLE_SIZE> queue;
+    // only called in builds with PUZZLE_STATS
+    queue.stats().on_progress([](const puzzle::search_progress& progress) {
+        std::cerr << "{\"processed\":" << progress.processed << ",\"touched\":" << progress.touched << ",\"seconds\":" << progress.seconds
+                  << ",\"nodes_per_s\":" << progress.nodes_per_s << ",\"f_bound\":" << progress.f_bound << "}\n";
+    });
+    if (mode == "--pdb" && argc == 3) {
+        const auto pdb = puzzle::pattern_database<PUZZLE_SIZE>::load(argv[2]);
+        sol = puzzle::find_solution<PUZZLE_SIZE>(permut, pdb.heuristic(), queue);
+    } else if (mode == "--anytime" && argc == 3) {
+        puzzle::anytime_limits limits;
+        limits.time_budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(std::stod(argv[2])));
+        sol = puzzle::find_solution_anytime<PUZZLE_SIZE>(permut, puzzle::linear_conflict_heuristic<PUZZLE_SIZE>{}, limits, queue, [](const auto& better) {
+            std::cerr << "steps " << better.steps.size() - 1 << " bound " << better.bound << '\n';
+        });
+    } else if (mode == "--memory" && argc == 3) {
+        puzzle::memory_limit limit{std::stoul(argv[2]) << 20};
+        sol = puzzle::find_solution_memory_bounded<PUZZLE_SIZE>(permut, puzzle::linear_conflict_heuristic<PUZZLE_SIZE>{}, limit);
+        std::cerr << "max_nodes " << limit.max_nodes << " frontier_nodes " << limit.frontier_nodes << " dfs_processed " << limit.dfs_processed << '\n';
+#if PUZZLE_SIZE <= 4
+    } else if (mode == "--wd" && argc == 2) {
+        sol = puzzle::find_solution<PUZZLE_SIZE>(permut, puzzle::walking_distance_wlc_heuristic<PUZZLE_SIZE>{}, queue);
+#endif
+    } else if (mode == "--ida" && argc == 2) {
+        sol = puzzle::find_solution_ida<PUZZLE_SIZE>(permut, puzzle::linear_conflict_heuristic<PUZZLE_SIZE>{});
+    } else if (mode == "--hda" && argc == 2) {
+        sol = puzzle::find_solution_hda<PUZZLE_SIZE>(permut, puzzle::linear_conflict_heuristic<PUZZLE_SIZE>{});
+    } else {
+        // sol = puzzle::find_solution_manhattan<PUZZLE_SIZE>(permut, queue);
+        puzzle::linear_conflict_heuristic<PUZZLE_SIZE> additional;
+        sol = puzzle::find_solution_manhattan_wadditional<PUZZLE_SIZE>(permut, additional, queue);
+    }
     if (sol.has_value()) {
-        solution_print(std::cout, *sol, print_mode::basic | print_mode::w_steps);
+        solution_print(std::cout, *sol, print_mode::basic | print_mode::w_moves);
+#if PUZZLE_STATS
+        sol->stats.write_json(std::cout) << '\n';
+#endif
     } else {
         std::cout << "no solution\n";
     }
@@ -0,0 +1,231 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "15puzzle.h"
+#include "15puzzle_anytime.h"
+#include "15puzzle_async.h"
+#include "15puzzle_bidirectional.h"
+#include "15puzzle_cache.h"
+#include "15puzzle_distance_table.h"
+#include "15puzzle_frontier.h"
+#include "15puzzle_generator.h"
+#include "15puzzle_hda.h"
+#include "15puzzle_memory_bounded.h"
+#include "15puzzle_pdb.h"
+#include "15puzzle_solver.h"
+#include "15puzzle_walking_distance.h"
+
+namespace {
+
+constexpr uint32_t psize = 3;
+using permut = puzzle::permut_t<psize>;
+using solution = puzzle::solution_t<psize>;
+
+struct solver {
+    std::string name;
+    std::function<std::optional<solution>(permut)> solve;
+};
+
+// every solver here has to return an optimal solution
+std::vector<solver> optimal_solvers(const puzzle::pattern_database<psize>& pdb) {
+    const puzzle::linear_conflict_heuristic<psize> lc;
+    const puzzle::walking_distance_heuristic<psize> wd;
+    const puzzle::walking_distance_wlc_heuristic<psize> wd_lc;
+    const puzzle::pdb_heuristic<psize> pdb_h = pdb.heuristic();
+    auto cache = std::make_shared<puzzle::solution_cache<psize>>(16);
+    auto hda = std::make_shared<puzzle::hda_search<psize, decltype(lc)>>(puzzle::permut_goal<psize>, lc, 3);
+    return {
+        {"find_solution/heap", [](permut p) { return puzzle::find_solution<psize>(p, puzzle::manhattan_dist_wlc<psize>); }},
+        {"find_solution/bucket", [](permut p) { return puzzle::find_solution<psize, decltype(&puzzle::manhattan_dist_wlc<psize>), puzzle::puzzle_bucket_queue>(p, puzzle::manhattan_dist_wlc<psize>); }},
+        {"find_solution/pdb", [pdb_h](permut p) { return puzzle::find_solution<psize>(p, pdb_h); }},
+        {"find_solution/wd", [wd](permut p) { return puzzle::find_solution<psize>(p, wd); }},
+        {"find_solution/wd_lc", [wd_lc](permut p) { return puzzle::find_solution<psize>(p, wd_lc); }},
+        {"find_solution_manhattan/heap", [](permut p) { return puzzle::find_solution_manhattan<psize>(p); }},
+        {"find_solution_manhattan/bucket", [](permut p) { return puzzle::find_solution_manhattan<psize, puzzle::puzzle_bucket_queue>(p); }},
+        {"find_solution_manhattan_wadditional/heap", [lc](permut p) { return puzzle::find_solution_manhattan_wadditional<psize>(p, lc); }},
+        {"find_solution_manhattan_wadditional/bucket", [lc](permut p) { return puzzle::find_solution_manhattan_wadditional<psize, decltype(lc), puzzle::puzzle_bucket_queue>(p, lc); }},
+        {"find_solution_epea/heap", [lc](permut p) { return puzzle::find_solution_epea<psize>(p, lc); }},
+        {"find_solution_epea/bucket", [lc](permut p) { return puzzle::find_solution_epea<psize, decltype(lc), puzzle::puzzle_bucket_queue>(p, lc); }},
+        {"find_solution_ida", [lc](permut p) { return puzzle::find_solution_ida<psize>(p, lc); }},
+        {"find_solution_anytime", [lc](permut p) { return puzzle::find_solution_anytime<psize>(p, lc, puzzle::anytime_limits{}); }},
+        {"find_solution_bidirectional", [](permut p) { return puzzle::find_solution_bidirectional<psize>(p); }},
+        {"find_solution_frontier", [](permut p) { return puzzle::find_solution_frontier<psize>(p); }},
+        {"find_solution_hda/4", [lc](permut p) { return puzzle::find_solution_hda<psize>(p, lc, 4); }},
+        {"hda_search/reused", [hda](permut p) { return hda->solve(p); }},
+        {"find_solution_memory_bounded/64KiB", [lc](permut p) {
+             puzzle::memory_limit limit{size_t{64} << 10};
+             return puzzle::find_solution_memory_bounded<psize>(p, lc, limit);
+         }},
+        {"find_solution_cached", [lc, cache](permut p) { return puzzle::find_solution_cached<psize>(p, lc, *cache); }},
+        {"find_solution_limited", [lc](permut p) -> std::optional<solution> {
+             puzzle::puzzle_bucket_queue_t<psize> queue;
+             return puzzle::find_solution_limited<psize>(p, lc, puzzle::solve_limits{}, queue).solution;
+         }},
+    };
+}
+
+// steps run from the goal back to initial one move at a time
+bool valid_path(const solution& sol, permut initial) {
+    if (sol.steps.empty() || sol.steps.front() != puzzle::permut_goal<psize> || sol.steps.back() != initial) {
+        return false;
+    }
+    for (size_t i = 1; i < sol.steps.size(); ++i) {
+        bool neighbours = false;
+        for (permut n : puzzle::permut_neighbors_itr<psize>(sol.steps[i])) {
+            neighbours |= n == sol.steps[i - 1];
+        }
+        if (!neighbours) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// a file-backed cache keeps every board over a reopen, with its index and after building the index again; capacity 1 sends the
+// lookups to the file, and more boards than the smallest index takes make it grow
+bool cache_file_checks(const puzzle::distance_table<psize>& table) {
+    const std::string path = "test_cache.bin";
+    const std::string index_path = path + ".index";
+    std::remove(path.c_str());
+    std::remove(index_path.c_str());
+    std::mt19937_64 src_of_randomnes(21);
+    std::vector<permut> boards(5000);
+    for (permut& board : boards) {
+        board = puzzle::permut_random<psize>(src_of_randomnes);
+    }
+    size_t stored = 0;
+    {
+        puzzle::solution_cache<psize> cache(1, path);
+        for (permut board : boards) {
+            cache.insert(board, puzzle::solution_moves<psize>(table.solve(board)->steps));
+        }
+        stored = cache.size();
+    }
+    auto all_found = [&] {
+        puzzle::solution_cache<psize> cache(1, path);
+        bool ok = cache.size() == stored;
+        for (size_t i = 0; ok && i < boards.size(); ++i) {
+            const auto moves = cache.find(boards[i]);
+            ok = moves && valid_path(solution{0, 0, puzzle::moves_steps<psize>(boards[i], *moves)}, boards[i]) &&
+                 moves->size() + 1 == table.solve(boards[i])->steps.size();
+        }
+        return ok;
+    };
+    bool ok = stored > 3072 && all_found();
+    std::remove(index_path.c_str());
+    ok = ok && all_found() && all_found();
+    std::remove(path.c_str());
+    std::remove(index_path.c_str());
+    return ok;
+}
+
+// a saved database loads back, and one whose second pattern repeats a tile of the first is refused
+bool pdb_load_checks_tiles(const puzzle::pattern_database<psize>& pdb) {
+    const std::string path = "test_pdb.bin";
+    pdb.save(path);
+    bool ok = true;
+    try {
+        puzzle::pattern_database<psize>::load(path);
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        // header, the first descriptor, then the second descriptor's offset, size and n_tiles
+        file.seekp(24 + 48 + 20);
+        file.put('\0');
+        file.close();
+        puzzle::pattern_database<psize>::load(path);
+        ok = false;
+    } catch (const std::runtime_error& e) {
+        ok = ok && std::string(e.what()).find("disjoint") != std::string::npos;
+    }
+    std::remove(path.c_str());
+    return ok;
+}
+
+// the same seed gives the same boards on 1 and 4 threads, every board is solvable and its estimate lies in the range and in its bucket;
+// a range the estimate never reaches has to end in an error, and so does a lowest estimate that only fits after wrapping around dist_type
+bool generator_checks() {
+    const puzzle::walking_distance_wlc_heuristic<psize> heuristic;
+    auto estimate = [&heuristic](permut p) -> puzzle::dist_type {
+        return heuristic(p);
+    };
+    puzzle::generator_options options;
+    options.seed = 25;
+    options.min_estimate = 12;
+    options.max_estimate = 18;
+    constexpr uint32_t bucket_width = 4;
+    constexpr size_t count = 10000;
+    std::vector<std::vector<puzzle::generated_instance<psize>>> runs;
+    for (size_t n_threads : {1, 4}) {
+        puzzle::thread_pool pool(n_threads);
+        auto& run = runs.emplace_back();
+        puzzle::generate_instances<psize>(pool, count, options, estimate, [&run](const puzzle::generated_instance<psize>& instance) {
+            run.push_back(instance);
+        });
+    }
+    bool ok = runs[0].size() == count && runs[1].size() == count;
+    for (size_t i = 0; ok && i < count; ++i) {
+        const auto& instance = runs[0][i];
+        const uint32_t low = puzzle::estimate_bucket(instance.estimate, bucket_width);
+        ok = instance.permut == runs[1][i].permut && puzzle::permut_solvable<psize>(instance.permut) && instance.estimate == heuristic(instance.permut) &&
+             instance.estimate >= options.min_estimate && instance.estimate <= options.max_estimate && low <= instance.estimate &&
+             instance.estimate < low + bucket_width && low % bucket_width == 0;
+    }
+    options.min_estimate = options.max_estimate = puzzle::max_solution_length<psize>;
+    options.max_draws_per_instance = 1000;
+    try {
+        puzzle::thread_pool pool(2);
+        puzzle::generate_instances<psize>(pool, count, options, estimate, [](const puzzle::generated_instance<psize>&) {});
+        ok = false;
+    } catch (const std::runtime_error&) {
+    }
+    constexpr unsigned long longest = puzzle::max_solution_length<psize>;
+    ok = ok && puzzle::min_estimate_of<psize>(longest) == longest && !puzzle::min_estimate_of<psize>(longest + 1) &&
+         !puzzle::min_estimate_of<psize>(longest + 256) && !puzzle::min_estimate_of<psize>(300);
+    return ok;
+}
+
+}  // namespace
+
+// every optimal solver against the 8-puzzle distance table on random boards
+int main(int argc, char* argv[]) {
+    const size_t n_boards = argc > 1 ? std::stoul(argv[1]) : 300;
+    const auto table = puzzle::distance_table<psize>::generate();
+    const auto pdb = puzzle::pattern_database<psize>::generate({{0, 1, 2, 3}, {4, 5, 6, 7}});
+    std::mt19937_64 src_of_randomnes(3);
+    std::vector<permut> boards(n_boards);
+    for (permut& board : boards) {
+        board = puzzle::permut_random<psize>(src_of_randomnes);
+    }
+    size_t failures = 0;
+    for (const solver& s : optimal_solvers(pdb)) {
+        size_t mismatches = 0;
+        for (permut board : boards) {
+            const auto expected = table.solve(board);
+            const auto sol = s.solve(board);
+            if (!sol || !valid_path(*sol, board) || sol->steps.size() != expected->steps.size()) {
+                if (mismatches++ == 0) {
+                    std::cerr << s.name << ": wrong solution for\n";
+                    puzzle::permut_write<psize>(std::cerr, board);
+                }
+            }
+        }
+        std::cout << s.name << ' ' << (mismatches == 0 ? "ok" : std::to_string(mismatches) + " of " + std::to_string(n_boards) + " wrong") << '\n';
+        failures += mismatches != 0;
+    }
+    const bool generator_ok = generator_checks();
+    std::cout << "generate_instances " << (generator_ok ? "ok" : "wrong") << '\n';
+    failures += !generator_ok;
+    const bool cache_ok = cache_file_checks(table);
+    std::cout << "solution_cache file " << (cache_ok ? "ok" : "wrong") << '\n';
+    failures += !cache_ok;
+    const bool pdb_ok = pdb_load_checks_tiles(pdb);
+    std::cout << "pattern_database::load " << (pdb_ok ? "ok" : "wrong") << '\n';
+    failures += !pdb_ok;
+    return failures == 0 ? 0 : 1;
+}